@@ -0,0 +1,88 @@
+/*
+ * Formatter benchmark (make format-bench / make format-bench-host).
+ *
+ * Formats the line shapes the framework emits with test_format() and with
+ * the C library's snprintf() (newlib-nano on target), checks that both give
+ * the same text, and reports one line per pattern on channel 0:
+ *
+ *   FMTBENCH:pattern:iterations:test_format_cycles:snprintf_cycles:length:match
+ *
+ * Cycle counts are totals over all iterations. make format-size compares the
+ * code size the two pull into an image. scripts/rtt_bench.py prints the table.
+ */
+
+#include "test_rtt_logger.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef FORMAT_BENCH_ITERATIONS
+#define FORMAT_BENCH_ITERATIONS 1000u
+#endif
+
+typedef int (*format_fn_t)(char* out, size_t size, const char* format, ...);
+
+static const char* const pattern_names[] = {
+    "log_prefix", "result", "signed", "hex", "padded", "string"
+};
+
+#define PATTERN_COUNT (sizeof(pattern_names) / sizeof(pattern_names[0]))
+
+/* volatile inputs keep the compiler from folding the calls */
+static volatile unsigned long bench_timestamp = 123456ul;
+static volatile long bench_negative = -12345l;
+static volatile unsigned bench_flags = 0x5u;
+
+static int format_pattern(format_fn_t fn, unsigned pattern, char* out, size_t size) {
+    switch (pattern) {
+        case 0:
+            return fn(out, size, "[%08lu] [%s] ", bench_timestamp, "INFO");
+        case 1:
+            return fn(out, size, "RESULT:%s:%s:%lu:%lu\r\n", "Calculate Sum Normal Cases", "PASS",
+                      12ul, bench_timestamp * 3u);
+        case 2:
+            return fn(out, size, "sum=%ld expected=%ld", bench_negative, 30l);
+        case 3:
+            return fn(out, size, "reg 0x%08lX flags %02x", 0xDEADBEEFul, bench_flags);
+        case 4:
+            return fn(out, size, "%-12s|%6u|%-4d|", "adc", 4095u, -7);
+        default:
+            return fn(out, size, "%s", "A plain message without any numeric conversions");
+    }
+}
+
+static uint32_t time_pattern(format_fn_t fn, unsigned pattern, char* out, size_t size) {
+    const uint32_t start = test_get_cycles();
+    for (uint32_t i = 0; i < FORMAT_BENCH_ITERATIONS; i++) {
+        format_pattern(fn, pattern, out, size);
+    }
+    return test_get_cycles() - start;
+}
+
+int main(void) {
+    char ours[128];
+    char libc[128];
+
+    test_rtt_init();
+    TEST_LOG_INFO("=== Formatter Benchmark ===");
+
+    for (unsigned p = 0; p < PATTERN_COUNT; p++) {
+        const uint32_t ours_cycles = time_pattern(test_format, p, ours, sizeof(ours));
+        const uint32_t libc_cycles = time_pattern(snprintf, p, libc, sizeof(libc));
+        const int length = format_pattern(test_format, p, ours, sizeof(ours));
+        const int libc_length = format_pattern(snprintf, p, libc, sizeof(libc));
+        const bool match = length == libc_length && strcmp(ours, libc) == 0;
+
+        test_rtt_printf(TEST_RECORD_CONTROL, "FMTBENCH:%s:%lu:%lu:%lu:%d:%u\r\n",
+                        pattern_names[p], (unsigned long)FORMAT_BENCH_ITERATIONS,
+                        (unsigned long)ours_cycles, (unsigned long)libc_cycles, length,
+                        match ? 1u : 0u);
+    }
+
+    test_rtt_printf(TEST_RECORD_CONTROL, "BENCHDONE:%lu\r\n", (unsigned long)PATTERN_COUNT);
+
+#if !TEST_HOST_BUILD
+    for (;;) {
+    }
+#endif
+    return 0;
+}
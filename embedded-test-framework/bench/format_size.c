@@ -0,0 +1,28 @@
+/*
+ * Code size probe (make format-size): the same log line formatted with
+ * snprintf() (FORMAT_SIZE_NEWLIB=1) or test_format(). Comparing the two
+ * images' text sizes gives what each formatter costs in flash.
+ */
+
+#include "SEGGER_RTT.h"
+#include <stdint.h>
+
+#if FORMAT_SIZE_NEWLIB
+#include <stdio.h>
+#define FORMAT snprintf
+#else
+#include "test_format.h"
+#define FORMAT test_format
+#endif
+
+static volatile uint32_t probe_value = 42u;
+
+int main(void) {
+    char line[64];
+    int length = FORMAT(line, sizeof(line), "[%08lu] [%s] %ld %lx %s\r\n",
+                        (unsigned long)probe_value, "INFO", -1l, 0xABul, "done");
+
+    SEGGER_RTT_Write(0, line, (unsigned)length);
+    for (;;) {
+    }
+}
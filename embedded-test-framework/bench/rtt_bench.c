@@ -0,0 +1,152 @@
+/*
+ * RTT throughput benchmark (make bench / make bench-host).
+ *
+ * For every buffer mode and size, writes fixed-size records to up channel
+ * BENCH_CHANNEL as fast as possible for BENCH_RUN_MS, then waits for the
+ * host to drain the buffer. Each run reports one line on channel 0:
+ *
+ *   BENCH:mode:size:record:attempted:accepted_bytes:short_writes:
+ *         writer_cycles:max_write_cycles:write_phase_cycles:elapsed_cycles:drained
+ *
+ * Runs start once the host has read channel 0 and the 4-byte preamble
+ * "BNCH" on the bench channel, so no run measures a probe that is still
+ * attaching. Bytes accepted into the ring are delivered unless the host stops reading,
+ * so delivered throughput is accepted_bytes over elapsed_cycles (write phase
+ * plus drain) and loss is attempted * record - accepted_bytes.
+ * scripts/rtt_bench.py captures the channel, checks the byte count and
+ * prints the comparison table.
+ */
+
+#include "test_rtt_logger.h"
+#include <string.h>
+
+#ifndef BENCH_RECORD_SIZE
+#define BENCH_RECORD_SIZE 16
+#endif
+
+#ifndef BENCH_RUN_MS
+#define BENCH_RUN_MS 250u
+#endif
+
+#ifndef BENCH_DRAIN_TIMEOUT_MS
+#define BENCH_DRAIN_TIMEOUT_MS 2000u
+#endif
+
+/* Comma-separated buffer sizes; the largest sets the static buffer */
+#ifndef BENCH_SIZES
+#define BENCH_SIZES 256, 1024, 4096
+#endif
+
+#ifndef BENCH_MAX_SIZE
+#define BENCH_MAX_SIZE 4096
+#endif
+
+#if BENCH_RECORD_SIZE < 4
+#error "BENCH_RECORD_SIZE must hold the 4-byte sequence number"
+#endif
+
+#define BENCH_CHANNEL 1
+
+typedef struct {
+    unsigned flags;
+    const char* name;
+} bench_mode_t;
+
+static const bench_mode_t bench_modes[] = {
+    { SEGGER_RTT_MODE_NO_BLOCK_SKIP,      "SKIP"  },
+    { SEGGER_RTT_MODE_NO_BLOCK_TRIM,      "TRIM"  },
+    { SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL, "BLOCK" },
+};
+
+static const unsigned bench_sizes[] = { BENCH_SIZES };
+
+static char bench_buffer[BENCH_MAX_SIZE];
+
+static const char bench_preamble[4] = { 'B', 'N', 'C', 'H' };
+
+/* Both the terminal and the bench channel reader must be attached */
+static void bench_wait_for_host(void) {
+    SEGGER_RTT_ConfigUpBuffer(BENCH_CHANNEL, "Bench", bench_buffer, sizeof(bench_buffer),
+                              SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    SEGGER_RTT_Write(BENCH_CHANNEL, bench_preamble, sizeof(bench_preamble));
+    
+    while (SEGGER_RTT_GetBytesInBuffer(0) != 0 || SEGGER_RTT_GetBytesInBuffer(BENCH_CHANNEL) != 0) {
+    }
+}
+
+static bool bench_drain(uint32_t start) {
+    const uint32_t timeout = BENCH_DRAIN_TIMEOUT_MS * (TEST_CPU_HZ / 1000u);
+    
+    while (SEGGER_RTT_GetBytesInBuffer(BENCH_CHANNEL) != 0) {
+        if (test_get_cycles() - start >= timeout) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void bench_run(const bench_mode_t* mode, unsigned size) {
+    const uint32_t run_cycles = BENCH_RUN_MS * (TEST_CPU_HZ / 1000u);
+    uint8_t record[BENCH_RECORD_SIZE];
+    uint32_t attempted = 0;
+    uint32_t accepted_bytes = 0;
+    uint32_t short_writes = 0;
+    uint32_t writer_cycles = 0;
+    uint32_t max_write_cycles = 0;
+    
+    memset(record, 0xA5, sizeof(record));
+    SEGGER_RTT_ConfigUpBuffer(BENCH_CHANNEL, "Bench", bench_buffer, size, mode->flags);
+    
+    const uint32_t start = test_get_cycles();
+    while (test_get_cycles() - start < run_cycles) {
+        memcpy(record, &attempted, sizeof(attempted));
+        
+        uint32_t before = test_get_cycles();
+        unsigned written = SEGGER_RTT_Write(BENCH_CHANNEL, record, sizeof(record));
+        uint32_t spent = test_get_cycles() - before;
+        
+        writer_cycles += spent;
+        if (spent > max_write_cycles) {
+            max_write_cycles = spent;
+        }
+        attempted++;
+        accepted_bytes += written;
+        if (written != sizeof(record)) {
+            short_writes++;
+        }
+    }
+    const uint32_t write_phase_cycles = test_get_cycles() - start;
+    
+    const bool drained = bench_drain(test_get_cycles());
+    const uint32_t elapsed_cycles = test_get_cycles() - start;
+    
+    SEGGER_RTT_printf(0, "BENCH:%s:%u:%u:%lu:%lu:%lu:%lu:%lu:%lu:%lu:%u\r\n",
+                     mode->name, size, (unsigned)sizeof(record), attempted, accepted_bytes,
+                     short_writes, writer_cycles, max_write_cycles, write_phase_cycles,
+                     elapsed_cycles, drained ? 1u : 0u);
+}
+
+int main(void) {
+    uint32_t runs = 0;
+    
+    test_rtt_init();
+    TEST_LOG_INFO("=== RTT Throughput Benchmark ===");
+    bench_wait_for_host();
+    
+    for (unsigned m = 0; m < sizeof(bench_modes) / sizeof(bench_modes[0]); m++) {
+        for (unsigned s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]); s++) {
+            if (bench_sizes[s] <= sizeof(bench_buffer)) {
+                bench_run(&bench_modes[m], bench_sizes[s]);
+                runs++;
+            }
+        }
+    }
+    
+    SEGGER_RTT_printf(0, "BENCHDONE:%lu\r\n", runs);
+    
+#if !TEST_HOST_BUILD
+    for (;;) {
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,432 @@
+#include "SEGGER_RTT.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* The segment's storage; _SEGGER_RTT is its start, so nm gives it the whole size */
+static char rtt_shm[RTT_SHM_SIZE] __attribute__((aligned(RTT_SHM_ALIGN)));
+extern SEGGER_RTT_CB _SEGGER_RTT __attribute__((alias("rtt_shm")));
+
+static rtt_shm_trailer_t* const shm_trailer =
+    (rtt_shm_trailer_t*)(rtt_shm + sizeof(SEGGER_RTT_CB));
+
+static char terminal_up_buffer[BUFFER_SIZE_UP];
+static char terminal_down_buffer[BUFFER_SIZE_DOWN];
+static FILE* channel_sinks[SEGGER_RTT_MAX_NUM_UP_BUFFERS];
+static int down_sources[SEGGER_RTT_MAX_NUM_DOWN_BUFFERS];
+static int initialized = 0;
+static int shared = 0;
+
+/* Swaps the pages under rtt_shm for the named segment; -1 leaves them as they are */
+static int map_shared_segment(const char* name) {
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    int result = -1;
+
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, RTT_SHM_SIZE) == 0 &&
+        mmap(rtt_shm, RTT_SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED) {
+        result = 0;
+    }
+    close(fd);
+    return result;
+}
+
+/* Ring storage inside the segment, 8-byte aligned; NULL when it is full */
+static char* shm_alloc(unsigned size) {
+    const uint32_t start = (shm_trailer->used + 7u) & ~7u;
+
+    if (size > RTT_SHM_SIZE || start > RTT_SHM_SIZE - size) {
+        fprintf(stderr, "SEGGER_RTT: %u byte ring does not fit in RTT_SHM_SIZE\n", size);
+        return NULL;
+    }
+    shm_trailer->used = start + size;
+    return rtt_shm + start;
+}
+
+/* A ring of at least size bytes in the segment, reusing the channel's current one if it is big enough */
+static char* shm_ring(char* current, unsigned current_size, unsigned size) {
+    if (current != NULL && current_size >= size) {
+        return current;
+    }
+    return shm_alloc(size);
+}
+
+void SEGGER_RTT_Init(void) {
+    if (initialized) {
+        return;
+    }
+    initialized = 1;
+
+    const char* shm_name = getenv("RTT_SHM_NAME");
+    if (shm_name != NULL) {
+        shared = map_shared_segment(shm_name) == 0;
+        if (!shared) {
+            fprintf(stderr, "SEGGER_RTT: cannot map %s, draining to stdout and files\n", shm_name);
+        }
+    }
+
+    memset(rtt_shm, 0, sizeof(SEGGER_RTT_CB) + sizeof(rtt_shm_trailer_t));
+    _SEGGER_RTT.MaxNumUpBuffers = SEGGER_RTT_MAX_NUM_UP_BUFFERS;
+    _SEGGER_RTT.MaxNumDownBuffers = SEGGER_RTT_MAX_NUM_DOWN_BUFFERS;
+    shm_trailer->base = (uint64_t)(uintptr_t)rtt_shm;
+    shm_trailer->size = RTT_SHM_SIZE;
+    shm_trailer->used = sizeof(SEGGER_RTT_CB) + sizeof(rtt_shm_trailer_t);
+
+    _SEGGER_RTT.aUp[0].sName = "Terminal";
+    _SEGGER_RTT.aUp[0].pBuffer = shared ? shm_alloc(BUFFER_SIZE_UP) : terminal_up_buffer;
+    _SEGGER_RTT.aUp[0].SizeOfBuffer = BUFFER_SIZE_UP;
+    _SEGGER_RTT.aDown[0].sName = "Terminal";
+    _SEGGER_RTT.aDown[0].pBuffer = shared ? shm_alloc(BUFFER_SIZE_DOWN) : terminal_down_buffer;
+    _SEGGER_RTT.aDown[0].SizeOfBuffer = BUFFER_SIZE_DOWN;
+    for (unsigned i = 0; i < SEGGER_RTT_MAX_NUM_DOWN_BUFFERS; i++) {
+        down_sources[i] = -1;
+    }
+
+    /* Written last, as on target: a reader must not find a half-built block */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(_SEGGER_RTT.acID, "SEGGER RTT", 11);
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+}
+
+static FILE* channel_sink(unsigned index) {
+    if (index == 0) {
+        return stdout;
+    }
+
+    if (channel_sinks[index] == NULL) {
+        char name[32];
+        snprintf(name, sizeof(name), "RTT_CHANNEL_%u_FILE", index);
+        const char* path = getenv(name);
+        if (path != NULL) {
+            channel_sinks[index] = fopen(path, "wb");
+        }
+    }
+
+    return channel_sinks[index];
+}
+
+/* Plays the part of the J-Link probe: empty the ring into the channel's sink */
+static void drain_up_buffer(unsigned index) {
+    SEGGER_RTT_BUFFER_UP* ring = &_SEGGER_RTT.aUp[index];
+
+    /* The monitor has the segment mapped and drains it itself */
+    if (shared) {
+        return;
+    }
+
+    FILE* sink = channel_sink(index);
+
+    while (ring->RdOff != ring->WrOff) {
+        unsigned end = ring->WrOff > ring->RdOff ? ring->WrOff : ring->SizeOfBuffer;
+        unsigned len = end - ring->RdOff;
+
+        if (sink != NULL) {
+            fwrite(ring->pBuffer + ring->RdOff, 1, len, sink);
+        }
+        ring->RdOff = (ring->RdOff + len) % ring->SizeOfBuffer;
+    }
+
+    if (sink != NULL && index != 0) {
+        fflush(sink);
+    }
+}
+
+static void open_down_source(unsigned index) {
+    char name[32];
+    snprintf(name, sizeof(name), "RTT_DOWN_CHANNEL_%u_FD", index);
+    const char* fd = getenv(name);
+
+    if (fd != NULL && down_sources[index] < 0) {
+        down_sources[index] = atoi(fd);
+        fcntl(down_sources[index], F_SETFL, fcntl(down_sources[index], F_GETFL) | O_NONBLOCK);
+    }
+}
+
+/* Plays the part of the probe on the way down: move pending host input into the ring */
+static void fill_down_buffer(unsigned index) {
+    SEGGER_RTT_BUFFER_DOWN* ring = &_SEGGER_RTT.aDown[index];
+
+    if (down_sources[index] < 0 || ring->SizeOfBuffer == 0) {
+        return;
+    }
+
+    for (;;) {
+        unsigned wr = ring->WrOff;
+        unsigned end = wr >= ring->RdOff ? ring->SizeOfBuffer - (ring->RdOff == 0 ? 1u : 0u)
+                                         : ring->RdOff - 1u;
+        if (end <= wr) {
+            return;
+        }
+
+        ssize_t n = read(down_sources[index], ring->pBuffer + wr, end - wr);
+        if (n <= 0) {
+            return;
+        }
+        ring->WrOff = (wr + (unsigned)n) % ring->SizeOfBuffer;
+    }
+}
+
+static unsigned avail_write_space(const SEGGER_RTT_BUFFER_UP* ring) {
+    unsigned rd = __atomic_load_n(&ring->RdOff, __ATOMIC_ACQUIRE);
+
+    if (rd <= ring->WrOff) {
+        return ring->SizeOfBuffer - 1u - ring->WrOff + rd;
+    }
+    return rd - ring->WrOff - 1u;
+}
+
+static void write_ring(SEGGER_RTT_BUFFER_UP* ring, const char* data, unsigned len) {
+    while (len > 0) {
+        unsigned chunk = ring->SizeOfBuffer - ring->WrOff;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(ring->pBuffer + ring->WrOff, data, chunk);
+        /* Data before the offset that publishes it, for a reader in another process */
+        __atomic_store_n(&ring->WrOff, (ring->WrOff + chunk) % ring->SizeOfBuffer, __ATOMIC_RELEASE);
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char* sName, void* pBuffer,
+                              unsigned BufferSize, unsigned Flags) {
+    SEGGER_RTT_Init();
+    if (BufferIndex >= SEGGER_RTT_MAX_NUM_UP_BUFFERS) {
+        return -1;
+    }
+
+    SEGGER_RTT_BUFFER_UP* ring = &_SEGGER_RTT.aUp[BufferIndex];
+    if (BufferIndex > 0 || pBuffer != NULL) {
+        if (shared) {
+            pBuffer = shm_ring(ring->pBuffer, ring->SizeOfBuffer, BufferSize);
+            if (pBuffer == NULL) {
+                return -1;
+            }
+        }
+        ring->sName = sName;
+        ring->SizeOfBuffer = 0;     /* a reader must not see the new buffer with the old size */
+        ring->pBuffer = pBuffer;
+        ring->RdOff = 0;
+        ring->WrOff = 0;
+        ring->SizeOfBuffer = BufferSize;
+        if (!shared) {
+            channel_sink(BufferIndex);  /* an empty capture still leaves a file behind */
+        }
+    }
+    ring->Flags = Flags;
+    return 0;
+}
+
+int SEGGER_RTT_ConfigDownBuffer(unsigned BufferIndex, const char* sName, void* pBuffer,
+                                unsigned BufferSize, unsigned Flags) {
+    SEGGER_RTT_Init();
+    if (BufferIndex >= SEGGER_RTT_MAX_NUM_DOWN_BUFFERS) {
+        return -1;
+    }
+
+    SEGGER_RTT_BUFFER_DOWN* ring = &_SEGGER_RTT.aDown[BufferIndex];
+    if (BufferIndex > 0 || pBuffer != NULL) {
+        if (shared) {
+            pBuffer = shm_ring(ring->pBuffer, ring->SizeOfBuffer, BufferSize);
+            if (pBuffer == NULL) {
+                return -1;
+            }
+        }
+        ring->sName = sName;
+        ring->SizeOfBuffer = 0;
+        ring->pBuffer = pBuffer;
+        ring->RdOff = 0;
+        ring->WrOff = 0;
+        ring->SizeOfBuffer = BufferSize;
+        open_down_source(BufferIndex);
+    }
+    ring->Flags = Flags;
+    return 0;
+}
+
+int SEGGER_RTT_SetModeUpBuffer(unsigned BufferIndex, unsigned Flags) {
+    if (BufferIndex >= SEGGER_RTT_MAX_NUM_UP_BUFFERS) {
+        return -1;
+    }
+    _SEGGER_RTT.aUp[BufferIndex].Flags = Flags;
+    return 0;
+}
+
+unsigned SEGGER_RTT_WriteNoLock(unsigned BufferIndex, const void* pBuffer, unsigned NumBytes) {
+    const char* data = (const char*)pBuffer;
+    unsigned written = 0;
+
+    if (BufferIndex >= SEGGER_RTT_MAX_NUM_UP_BUFFERS || _SEGGER_RTT.aUp[BufferIndex].SizeOfBuffer == 0) {
+        return 0;
+    }
+
+    SEGGER_RTT_BUFFER_UP* ring = &_SEGGER_RTT.aUp[BufferIndex];
+
+    switch (ring->Flags & SEGGER_RTT_MODE_MASK) {
+        case SEGGER_RTT_MODE_NO_BLOCK_SKIP:
+            if (avail_write_space(ring) >= NumBytes) {
+                write_ring(ring, data, NumBytes);
+                written = NumBytes;
+            }
+            break;
+        case SEGGER_RTT_MODE_NO_BLOCK_TRIM:
+            written = avail_write_space(ring);
+            if (written > NumBytes) {
+                written = NumBytes;
+            }
+            write_ring(ring, data, written);
+            break;
+        default:
+            while (written < NumBytes) {
+                unsigned chunk = avail_write_space(ring);
+                if (chunk > NumBytes - written) {
+                    chunk = NumBytes - written;
+                }
+                write_ring(ring, data + written, chunk);
+                written += chunk;
+                drain_up_buffer(BufferIndex);
+                if (chunk == 0 && shared) {
+                    sched_yield();      /* the monitor frees space at its own pace */
+                }
+            }
+            break;
+    }
+
+    drain_up_buffer(BufferIndex);
+    return written;
+}
+
+unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void* pBuffer, unsigned NumBytes) {
+    SEGGER_RTT_Init();
+    return SEGGER_RTT_WriteNoLock(BufferIndex, pBuffer, NumBytes);
+}
+
+unsigned SEGGER_RTT_WriteString(unsigned BufferIndex, const char* s) {
+    return SEGGER_RTT_Write(BufferIndex, s, (unsigned)strlen(s));
+}
+
+unsigned SEGGER_RTT_Read(unsigned BufferIndex, void* pBuffer, unsigned BufferSize) {
+    SEGGER_RTT_Init();
+    if (BufferIndex >= SEGGER_RTT_MAX_NUM_DOWN_BUFFERS) {
+        return 0;
+    }
+
+    SEGGER_RTT_BUFFER_DOWN* ring = &_SEGGER_RTT.aDown[BufferIndex];
+    char* out = (char*)pBuffer;
+    unsigned count = 0;
+
+    fill_down_buffer(BufferIndex);
+
+    const unsigned wr = __atomic_load_n(&ring->WrOff, __ATOMIC_ACQUIRE);
+    while (count < BufferSize && ring->RdOff != wr) {
+        out[count++] = ring->pBuffer[ring->RdOff];
+        ring->RdOff = (ring->RdOff + 1u) % ring->SizeOfBuffer;
+    }
+    return count;
+}
+
+unsigned SEGGER_RTT_GetAvailWriteSpace(unsigned BufferIndex) {
+    return avail_write_space(&_SEGGER_RTT.aUp[BufferIndex]);
+}
+
+unsigned SEGGER_RTT_GetBytesInBuffer(unsigned BufferIndex) {
+    const SEGGER_RTT_BUFFER_UP* ring = &_SEGGER_RTT.aUp[BufferIndex];
+    unsigned rd = ring->RdOff;
+
+    if (rd <= ring->WrOff) {
+        return ring->WrOff - rd;
+    }
+    return ring->SizeOfBuffer - rd + ring->WrOff;
+}
+
+unsigned SEGGER_RTT_GetUpBufferReadPos(unsigned BufferIndex) {
+    return _SEGGER_RTT.aUp[BufferIndex].RdOff;
+}
+
+/*
+ * Same conversions as SEGGER_RTT_printf(): c, d, u, x, X, s, p and %% with
+ * '-', '0', '+' flags, width and precision. Like the target implementation,
+ * 'l' and 'h' are accepted and ignored; integers are read as int. Returns the
+ * bytes stored, or -1 if the output did not fit.
+ */
+int SEGGER_RTT_vprintf(unsigned BufferIndex, const char* sFormat, va_list* pParamList) {
+    char out[256];
+    size_t len = 0;
+
+    while (*sFormat != '\0' && len < sizeof(out) - 1) {
+        if (*sFormat != '%') {
+            out[len++] = *sFormat++;
+            continue;
+        }
+
+        char spec[16] = "%";
+        size_t spec_len = 1;
+        sFormat++;
+        while (*sFormat != '\0' && strchr("-0+ .0123456789", *sFormat) != NULL && spec_len < 12) {
+            spec[spec_len++] = *sFormat++;
+        }
+        while (*sFormat == 'l' || *sFormat == 'h') {
+            sFormat++;
+        }
+
+        char conversion = *sFormat;
+        if (conversion == '\0') {
+            break;
+        }
+        sFormat++;
+        spec[spec_len++] = conversion;
+        spec[spec_len] = '\0';
+
+        size_t room = sizeof(out) - len;
+        int n = 0;
+        switch (conversion) {
+            case 'd':
+            case 'c':
+                n = snprintf(out + len, room, spec, va_arg(*pParamList, int));
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+                n = snprintf(out + len, room, spec, va_arg(*pParamList, unsigned));
+                break;
+            case 's':
+                n = snprintf(out + len, room, spec, va_arg(*pParamList, const char*));
+                break;
+            case 'p':
+                n = snprintf(out + len, room, "%08X", (unsigned)(size_t)va_arg(*pParamList, void*));
+                break;
+            case '%':
+                n = snprintf(out + len, room, "%%");
+                break;
+            default:
+                break;
+        }
+        if (n > 0) {
+            len += ((size_t)n < room) ? (size_t)n : room - 1;
+        }
+    }
+
+    /* Like the target: -1 when the line did not fit completely */
+    if (SEGGER_RTT_Write(BufferIndex, out, (unsigned)len) != len) {
+        return -1;
+    }
+    return (int)len;
+}
+
+int SEGGER_RTT_printf(unsigned BufferIndex, const char* sFormat, ...) {
+    va_list args;
+    int result;
+
+    va_start(args, sFormat);
+    result = SEGGER_RTT_vprintf(BufferIndex, sFormat, &args);
+    va_end(args);
+    return result;
+}
@@ -0,0 +1,116 @@
+#ifndef SEGGER_RTT_H
+#define SEGGER_RTT_H
+
+/*
+ * Host RTT shim: the subset of the SEGGER RTT API used by the framework, for
+ * running the firmware as a host process (make host). The control block and
+ * ring buffers follow the SEGGER layout; what the J-Link probe would read is
+ * drained synchronously after each write: channel 0 to stdout, other up
+ * channels to the file named by RTT_CHANNEL_<n>_FILE (discarded if unset).
+ * Down channels other than 0 are fed from the file descriptor number in
+ * RTT_DOWN_CHANNEL_<n>_FD, typically a pipe the host monitor writes to.
+ *
+ * With RTT_SHM_NAME set, nothing is drained here. The control block and all
+ * rings move into the POSIX shared-memory segment of that name, mapped over
+ * the RTT_SHM_SIZE bytes that hold _SEGGER_RTT, and the monitor reads and
+ * writes them like a probe (rtt_monitor.py --host-transport shm). Full rings
+ * then skip, trim or block as they do on the target. The segment is:
+ *
+ *   _SEGGER_RTT                        host layout: pointers are 64-bit
+ *   rtt_shm_trailer_t                  where the segment is mapped in this process
+ *   ring buffers                       allocated by ConfigUp/DownBuffer
+ *
+ * The buffers the caller passes to SEGGER_RTT_ConfigUpBuffer() are not used
+ * in this mode. A channel that does not fit in the segment is left unconfigured.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+
+#ifndef SEGGER_RTT_MAX_NUM_UP_BUFFERS
+#define SEGGER_RTT_MAX_NUM_UP_BUFFERS    8
+#endif
+
+#ifndef SEGGER_RTT_MAX_NUM_DOWN_BUFFERS
+#define SEGGER_RTT_MAX_NUM_DOWN_BUFFERS  3
+#endif
+
+#ifndef BUFFER_SIZE_UP
+#define BUFFER_SIZE_UP    1024
+#endif
+
+#ifndef BUFFER_SIZE_DOWN
+#define BUFFER_SIZE_DOWN  16
+#endif
+
+/* Whole pages of the largest size Linux uses, since the segment is mapped over it */
+#ifndef RTT_SHM_SIZE
+#define RTT_SHM_SIZE  (256u * 1024u)
+#endif
+#define RTT_SHM_ALIGN 65536u
+
+#define SEGGER_RTT_MODE_NO_BLOCK_SKIP       0
+#define SEGGER_RTT_MODE_NO_BLOCK_TRIM       1
+#define SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL  2
+#define SEGGER_RTT_MODE_MASK                3
+
+typedef struct {
+    const char* sName;
+    char* pBuffer;
+    unsigned SizeOfBuffer;
+    unsigned WrOff;
+    volatile unsigned RdOff;
+    unsigned Flags;
+} SEGGER_RTT_BUFFER_UP;
+
+typedef struct {
+    const char* sName;
+    char* pBuffer;
+    unsigned SizeOfBuffer;
+    volatile unsigned WrOff;
+    unsigned RdOff;
+    unsigned Flags;
+} SEGGER_RTT_BUFFER_DOWN;
+
+typedef struct {
+    char acID[16];
+    int MaxNumUpBuffers;
+    int MaxNumDownBuffers;
+    SEGGER_RTT_BUFFER_UP aUp[SEGGER_RTT_MAX_NUM_UP_BUFFERS];
+    SEGGER_RTT_BUFFER_DOWN aDown[SEGGER_RTT_MAX_NUM_DOWN_BUFFERS];
+} SEGGER_RTT_CB;
+
+/* Follows the control block; lets the reader turn pBuffer into a segment offset */
+typedef struct {
+    uint64_t base;          /* address of _SEGGER_RTT in the firmware process */
+    uint32_t size;          /* RTT_SHM_SIZE */
+    uint32_t used;          /* bytes taken by the control block, trailer and rings */
+} rtt_shm_trailer_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern SEGGER_RTT_CB _SEGGER_RTT;
+
+void SEGGER_RTT_Init(void);
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char* sName, void* pBuffer,
+                              unsigned BufferSize, unsigned Flags);
+int SEGGER_RTT_ConfigDownBuffer(unsigned BufferIndex, const char* sName, void* pBuffer,
+                                unsigned BufferSize, unsigned Flags);
+int SEGGER_RTT_SetModeUpBuffer(unsigned BufferIndex, unsigned Flags);
+unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void* pBuffer, unsigned NumBytes);
+unsigned SEGGER_RTT_WriteNoLock(unsigned BufferIndex, const void* pBuffer, unsigned NumBytes);
+unsigned SEGGER_RTT_WriteString(unsigned BufferIndex, const char* s);
+unsigned SEGGER_RTT_Read(unsigned BufferIndex, void* pBuffer, unsigned BufferSize);
+unsigned SEGGER_RTT_GetAvailWriteSpace(unsigned BufferIndex);
+unsigned SEGGER_RTT_GetBytesInBuffer(unsigned BufferIndex);
+unsigned SEGGER_RTT_GetUpBufferReadPos(unsigned BufferIndex);
+int SEGGER_RTT_printf(unsigned BufferIndex, const char* sFormat, ...);
+int SEGGER_RTT_vprintf(unsigned BufferIndex, const char* sFormat, va_list* pParamList);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef TEST_BULK_H
+#define TEST_BULK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Bulk binary dumps of sample buffers (make BULK=1).
+ *
+ * test_dump_binary() and test_dump_array() stream raw memory on RTT channel
+ * RTT_CHANNEL_BULK as frames [tag:1][length:4][payload], like the coverage
+ * stream:
+ *
+ *   'H'  starts a dump: [type:1][flags:1][count:4][sequence:4][name]
+ *   'D'  next chunk of the (possibly encoded) element data
+ *   'E'  ends it: [raw bytes:4][encoded bytes:4]
+ *
+ * Uncompressed data goes straight from the source buffer in chunks that start
+ * on word boundaries. TEST_BULK_DELTA replaces each element with its
+ * difference from the previous one (wrapping, at the element width) and
+ * TEST_BULK_RLE run-length codes the resulting bytes: a control byte below
+ * 0x80 is followed by that many plus one literal bytes, one at or above 0x80
+ * by a single byte repeated (control - 0x80 + 3) times.
+ *
+ * Each frame is one write in SKIP mode, and the channel is flow-controlled
+ * when FLOW=1. Once a frame does not fit, the rest of that dump is not sent
+ * (no 'E' frame), the dump is counted as dropped and the call returns false;
+ * without a reader the target keeps running. scripts/bulk_dump.py writes the
+ * complete dumps to .npy or raw files and skips the cut ones.
+ */
+
+#ifndef TEST_BULK_ENABLED
+#define TEST_BULK_ENABLED 0
+#endif
+
+#ifndef RTT_BUFFER_BULK_SIZE
+#define RTT_BUFFER_BULK_SIZE 2048
+#endif
+
+/* Largest data frame; the encoder stages this much */
+#ifndef TEST_BULK_CHUNK
+#define TEST_BULK_CHUNK 256
+#endif
+
+/* Encoding used by test_dump_binary() */
+#ifndef TEST_BULK_DEFAULT_FLAGS
+#define TEST_BULK_DEFAULT_FLAGS 0
+#endif
+
+#define TEST_BULK_TAG_HEADER  'H'
+#define TEST_BULK_TAG_DATA    'D'
+#define TEST_BULK_TAG_END     'E'
+
+/* Element types, numbered as in scripts/bulk_dump.py */
+#define TEST_BULK_U8    0
+#define TEST_BULK_I8    1
+#define TEST_BULK_U16   2
+#define TEST_BULK_I16   3
+#define TEST_BULK_U32   4
+#define TEST_BULK_I32   5
+#define TEST_BULK_F32   6
+
+#define TEST_BULK_DELTA 0x01
+#define TEST_BULK_RLE   0x02
+
+#if TEST_BULK_ENABLED
+void test_bulk_init(void);
+bool test_dump_binary(const char* tag, const void* data, uint32_t length);
+bool test_dump_array(const char* tag, const void* data, uint32_t count, uint8_t type, uint8_t flags);
+void test_bulk_report(void);
+#else
+#define test_dump_binary(tag, data, length)             (false)
+#define test_dump_array(tag, data, count, type, flags)  (false)
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TEST_COVERAGE_H
+#define TEST_COVERAGE_H
+
+#include <stdint.h>
+
+/*
+ * gcov coverage from target runs (make COVERAGE=1, GCC 12 or later).
+ *
+ * Sources are built with -fprofile-arcs -ftest-coverage -fprofile-info-section
+ * and config/gcov_info.ld collects the gcov_info pointers between
+ * __gcov_info_start and __gcov_info_end. test_coverage_dump() serializes every
+ * object's counters with __gcov_info_to_gcda() and streams the .gcda images on
+ * RTT channel RTT_CHANNEL_COVERAGE as frames [tag:1][length:4][payload]:
+ *
+ *   'F'  .gcda path recorded at compile time; starts a new file
+ *   'D'  next chunk of that file's .gcda data
+ *   'E'  end of dump, payload is the number of files (4 bytes)
+ *
+ * The channel blocks when full so no counter is lost: capture it whenever the
+ * firmware is built with coverage. scripts/coverage.py rebuilds the .gcda
+ * files and merges them across runs.
+ */
+
+#ifndef TEST_COVERAGE_ENABLED
+#define TEST_COVERAGE_ENABLED 0
+#endif
+
+#ifndef RTT_BUFFER_COVERAGE_SIZE
+#define RTT_BUFFER_COVERAGE_SIZE 1024
+#endif
+
+/* Scratch memory for __gcov_info_to_gcda(); only value-profile counters use it */
+#ifndef TEST_COVERAGE_POOL_SIZE
+#define TEST_COVERAGE_POOL_SIZE 256
+#endif
+
+#define TEST_COVERAGE_TAG_FILE  'F'
+#define TEST_COVERAGE_TAG_DATA  'D'
+#define TEST_COVERAGE_TAG_END   'E'
+
+void test_coverage_init(void);
+void test_coverage_dump(void);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef TEST_FAULT_H
+#define TEST_FAULT_H
+
+#include <stdint.h>
+
+/*
+ * Fault handler with a crash record (make FAULT=1).
+ *
+ * HardFault, MemManage, BusFault and UsageFault all enter
+ * test_fault_handler() with the stacked exception frame and EXC_RETURN. It
+ * builds a test_fault_record_t: the stacked registers, CFSR/HFSR/MMFAR/BFAR,
+ * the running test and the first TEST_FAULT_STACK_WORDS words of the stack
+ * above the frame. The record goes to channel 0 as one control line, so the
+ * monitor sees it without a capture and POSTMORTEM=1 keeps it across a reset:
+ *
+ *   CRASH:<record as little-endian hex>:<running test name>
+ *
+ * The target then spins, or resets when TEST_FAULT_RESET is 1. rtt_monitor.py
+ * --elf decodes the fault status bits, fails the running test and prints a
+ * backtrace built from PC, LR and the code addresses found in the stack
+ * words, symbolized from the ELF; scripts/crash_report.py does the same for a
+ * saved log.
+ *
+ * TEST_FAULT_INSTALL_HANDLERS 0 leaves the four handlers to the application,
+ * which calls test_fault_handler() from its own with the same arguments (see
+ * the handlers in test_fault.c). Host builds catch SIGSEGV, SIGBUS, SIGILL
+ * and SIGFPE instead; kind is then 0x80 plus the signal number, CFSR holds
+ * si_code and MMFAR the faulting address.
+ */
+
+#ifndef TEST_FAULT_ENABLED
+#define TEST_FAULT_ENABLED 0
+#endif
+
+#ifndef TEST_FAULT_INSTALL_HANDLERS
+#define TEST_FAULT_INSTALL_HANDLERS 1
+#endif
+
+#ifndef TEST_FAULT_STACK_WORDS
+#define TEST_FAULT_STACK_WORDS 16u
+#endif
+
+#ifndef TEST_FAULT_RESET
+#define TEST_FAULT_RESET 0
+#endif
+
+#define TEST_FAULT_RECORD_VERSION 1u
+
+/* Exception numbers; host signals are TEST_FAULT_HOST_SIGNAL | signo */
+#define TEST_FAULT_HARD         3u
+#define TEST_FAULT_MEMMANAGE    4u
+#define TEST_FAULT_BUS          5u
+#define TEST_FAULT_USAGE        6u
+#define TEST_FAULT_HOST_SIGNAL  0x80u
+
+/* All fields 32-bit little-endian words, in this order */
+typedef struct {
+    uint8_t version;
+    uint8_t kind;
+    uint16_t stack_words;               /* valid entries in stack[] */
+    uint32_t r0, r1, r2, r3, r12, lr, pc, xpsr;
+    uint32_t sp;                        /* first word above the exception frame */
+    uint32_t exc_return;
+    uint32_t cfsr, hfsr, mmfar, bfar;
+    uint32_t test_index;                /* 1-based position of the running test, 0 if none */
+    uint32_t cycles;
+    uint32_t stack[TEST_FAULT_STACK_WORDS];
+} test_fault_record_t;
+
+#if TEST_FAULT_ENABLED
+void test_fault_init(void);
+void test_fault_handler(const uint32_t* frame, uint32_t exc_return);
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TEST_FLOW_H
+#define TEST_FLOW_H
+
+#include "SEGGER_RTT.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Credit-based flow control for the binary up channels (make FLOW=1).
+ *
+ * The host grants credit on down channel RTT_CHANNEL_FLOW_DOWN with 5-byte
+ * little-endian records [channel:1][consumed:4], where consumed is the total
+ * number of bytes it has read from that up channel so far. A registered
+ * channel may have at most its window of bytes written but not yet consumed;
+ * test_flow_write() refuses records beyond that, and the producer counts the
+ * loss or falls back to a summary. A channel is only throttled once its first
+ * grant has arrived, so hosts that just capture (JLinkRTTLogger) see the
+ * channel exactly as before.
+ */
+
+#ifndef TEST_FLOW_ENABLED
+#define TEST_FLOW_ENABLED 0
+#endif
+
+#define RTT_CHANNEL_FLOW_DOWN  1
+#define TEST_FLOW_GRANT_SIZE   5
+
+#ifndef RTT_BUFFER_FLOW_DOWN_SIZE
+#define RTT_BUFFER_FLOW_DOWN_SIZE 64
+#endif
+
+/* Highest up channel index that can be registered, plus one */
+#ifndef TEST_FLOW_MAX_CHANNELS
+#define TEST_FLOW_MAX_CHANNELS 8
+#endif
+
+#if TEST_FLOW_ENABLED
+void test_flow_init(void);
+void test_flow_register(unsigned channel, uint32_t window);
+void test_flow_poll(void);
+uint32_t test_flow_credit(unsigned channel);
+unsigned test_flow_write(unsigned channel, const void* data, unsigned length);
+void test_flow_report(void);
+#else
+#define test_flow_register(channel, window)     ((void)0)
+#define test_flow_write(channel, data, length)  SEGGER_RTT_Write((channel), (data), (length))
+#endif
+
+#endif
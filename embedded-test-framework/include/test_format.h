@@ -0,0 +1,64 @@
+#ifndef TEST_FORMAT_H
+#define TEST_FORMAT_H
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Integer-only snprintf() replacement for the logger.
+ *
+ * Supports the conversions the framework and TEST_LOG_* callers use:
+ * d i u x X o c s p and %%, with the '-', '0', '+' and ' ' flags, width and
+ * precision (both may be '*'), and the hh h l ll z j t length modifiers.
+ * 64-bit values are only divided in 64 bits when they do not fit in 32.
+ * Floating-point conversions are not supported: they consume their double
+ * argument and print '?'. Like snprintf() the result is always terminated
+ * and the return value is the length the full output would have had.
+ *
+ * test_format_args() takes the arguments as an array instead of varargs,
+ * for the C++ front end in test_log.hpp. Each element already holds the
+ * full value for its conversion, so length modifiers are not applied.
+ * test_format_capture() goes the other way for deferred logging: it copies
+ * the varargs a format consumes into such an array, without formatting.
+ * %s arguments are kept as pointers, so the strings must outlive the array.
+ * test_format_conversions() lists the conversion character for each array
+ * slot ('*' for a width or precision argument).
+ *
+ * Callers are format-checked (TEST_FORMAT_PRINTF). uint32_t is unsigned long
+ * on the target and unsigned int on the host, so 32-bit values are printed
+ * with PRIu32/PRId32 (inttypes.h, included here) to check cleanly on both.
+ */
+
+#if defined(__GNUC__)
+#define TEST_FORMAT_PRINTF(format_index, first_arg) \
+    __attribute__((format(printf, format_index, first_arg)))
+#else
+#define TEST_FORMAT_PRINTF(format_index, first_arg)
+#endif
+
+/* One test_format_args() argument: i for d/i/c and '*', u for u/x/X/o */
+typedef union {
+    int64_t i;
+    uint64_t u;
+    const char* s;
+    const void* p;
+} test_format_arg_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int test_format(char* out, size_t size, const char* format, ...) TEST_FORMAT_PRINTF(3, 4);
+int test_vformat(char* out, size_t size, const char* format, va_list args) TEST_FORMAT_PRINTF(3, 0);
+int test_format_args(char* out, size_t size, const char* format,
+                     const test_format_arg_t* args, size_t count);
+size_t test_format_capture(const char* format, va_list args, test_format_arg_t* out, size_t max);
+size_t test_format_conversions(const char* format, char* out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef TEST_FUNC_TRACE_H
+#define TEST_FUNC_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Function entry/exit tracing for builds with -finstrument-functions
+ * (make FUNC_TRACE=1). Each hook writes one 8-byte record to RTT channel
+ * RTT_CHANNEL_FUNC_TRACE:
+ *
+ *   word 0: function address delta to the previous record, bit 0 set on exit
+ *   word 1: cycle delta to the previous record
+ *
+ * Thumb function addresses are odd, so address deltas are even and bit 0 is
+ * free for the exit flag. When records are dropped, the next record is
+ * preceded by a loss marker {0x00000000, 0xFFFFFFFF} and carries an absolute
+ * address. Hooks are not re-entrant: exclude ISR sources from instrumentation.
+ * scripts/func_trace.py symbolizes captures against the ELF.
+ */
+
+#ifndef TEST_FUNC_TRACE_ENABLED
+#define TEST_FUNC_TRACE_ENABLED 0
+#endif
+
+#ifndef RTT_BUFFER_FUNC_TRACE_SIZE
+#define RTT_BUFFER_FUNC_TRACE_SIZE 4096
+#endif
+
+#define TEST_FUNC_TRACE_LOSS_MARKER 0xFFFFFFFFu
+
+void test_func_trace_init(void);
+void test_func_trace_report(void);
+
+#endif
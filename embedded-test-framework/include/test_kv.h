@@ -0,0 +1,168 @@
+#ifndef TEST_KV_H
+#define TEST_KV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Structured key-value log records.
+ *
+ *   TEST_LOG_KV(TEST_LOG_LEVEL_ERROR, "calculate_sum", "a", a, "b", b, "overflow", true);
+ *
+ * Each value is typed from its C type (_Generic in C, overloads in C++):
+ * signed and unsigned integers, bool, float/double and strings. Up to
+ * TEST_KV_MAX_FIELDS pairs per record; a record without pairs is allowed.
+ * Records go to channel 0 under the level's write policy as one line
+ *
+ *   KV:<cycles>:<level>:<event> <key>=<type>:<value> ...
+ *
+ * with type i (signed), u (unsigned), b (bool), f (IEEE double bits, 16 hex
+ * digits) or s (string). Event, keys and strings are %XX-escaped for '%',
+ * ' ', '=' and control characters. Fields that would not fit in
+ * TEST_WRITE_LINE_MAX are left out and the line ends " ..." instead.
+ * rtt_monitor.py stores records in SQLite, one table per event with a column
+ * per key.
+ */
+
+#define TEST_KV_MAX_FIELDS 8
+
+#define TEST_KV_INT     'i'
+#define TEST_KV_UINT    'u'
+#define TEST_KV_BOOL    'b'
+#define TEST_KV_FLOAT   'f'
+#define TEST_KV_STRING  's'
+
+typedef struct {
+    const char* key;
+    char type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double f;
+        const char* s;
+    } value;
+} test_kv_t;
+
+static inline test_kv_t test_kv_int(const char* key, int64_t value) {
+    test_kv_t kv = { key, TEST_KV_INT, { 0 } };
+    kv.value.i = value;
+    return kv;
+}
+
+static inline test_kv_t test_kv_uint(const char* key, uint64_t value) {
+    test_kv_t kv = { key, TEST_KV_UINT, { 0 } };
+    kv.value.u = value;
+    return kv;
+}
+
+static inline test_kv_t test_kv_bool(const char* key, bool value) {
+    test_kv_t kv = { key, TEST_KV_BOOL, { 0 } };
+    kv.value.u = value ? 1u : 0u;
+    return kv;
+}
+
+static inline test_kv_t test_kv_float(const char* key, double value) {
+    test_kv_t kv = { key, TEST_KV_FLOAT, { 0 } };
+    kv.value.f = value;
+    return kv;
+}
+
+static inline test_kv_t test_kv_string(const char* key, const char* value) {
+    test_kv_t kv = { key, TEST_KV_STRING, { 0 } };
+    kv.value.s = value;
+    return kv;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void test_log_kv(int level, const char* event, const test_kv_t* fields, size_t count);
+
+#ifdef __cplusplus
+}
+
+#include <type_traits>
+
+template <typename T>
+inline test_kv_t test_kv(const char* key, const T& value) {
+    using U = std::decay_t<T>;
+    static_assert(std::is_arithmetic_v<U> || std::is_same_v<U, const char*> || std::is_same_v<U, char*>,
+                  "TEST_LOG_KV: values must be integers, bool, floating point or strings");
+    if constexpr (std::is_same_v<U, bool>) {
+        return test_kv_bool(key, value);
+    } else if constexpr (std::is_floating_point_v<U>) {
+        return test_kv_float(key, value);
+    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+        return test_kv_int(key, value);
+    } else if constexpr (std::is_integral_v<U>) {
+        return test_kv_uint(key, value);
+    } else {
+        return test_kv_string(key, value);
+    }
+}
+
+#define TEST_KV(key, value) test_kv(key, value)
+#else
+/* No default association: an unsupported value type fails to compile */
+#define TEST_KV(key, value) _Generic((value), \
+    _Bool: test_kv_bool, \
+    char: test_kv_int, \
+    signed char: test_kv_int, \
+    short: test_kv_int, \
+    int: test_kv_int, \
+    long: test_kv_int, \
+    long long: test_kv_int, \
+    unsigned char: test_kv_uint, \
+    unsigned short: test_kv_uint, \
+    unsigned int: test_kv_uint, \
+    unsigned long: test_kv_uint, \
+    unsigned long long: test_kv_uint, \
+    float: test_kv_float, \
+    double: test_kv_float, \
+    char*: test_kv_string, \
+    const char*: test_kv_string)(key, value)
+#endif
+
+/* Dispatch on the argument count: event plus 0..TEST_KV_MAX_FIELDS key/value pairs */
+#define TEST_KV_CAT_(a, b) a##b
+#define TEST_KV_CAT(a, b) TEST_KV_CAT_(a, b)
+#define TEST_KV_PAIRS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, n, ...) n
+#define TEST_KV_PAIRS(...) \
+    TEST_KV_PAIRS_(__VA_ARGS__, 8, odd, 7, odd, 6, odd, 5, odd, 4, odd, 3, odd, 2, odd, 1, odd, 0, odd)
+
+#define TEST_KV_EMIT(level, event, ...) \
+    do { \
+        const test_kv_t test_kv_fields_[] = { __VA_ARGS__ }; \
+        test_log_kv(level, event, test_kv_fields_, sizeof(test_kv_fields_) / sizeof(test_kv_fields_[0])); \
+    } while (0)
+
+#define TEST_KV_LOG_0(level, event) \
+    test_log_kv(level, event, NULL, 0)
+#define TEST_KV_LOG_1(level, event, k1, v1) \
+    TEST_KV_EMIT(level, event, TEST_KV(k1, v1))
+#define TEST_KV_LOG_2(level, event, k1, v1, k2, v2) \
+    TEST_KV_EMIT(level, event, TEST_KV(k1, v1), TEST_KV(k2, v2))
+#define TEST_KV_LOG_3(level, event, k1, v1, k2, v2, k3, v3) \
+    TEST_KV_EMIT(level, event, TEST_KV(k1, v1), TEST_KV(k2, v2), TEST_KV(k3, v3))
+#define TEST_KV_LOG_4(level, event, k1, v1, k2, v2, k3, v3, k4, v4) \
+    TEST_KV_EMIT(level, event, TEST_KV(k1, v1), TEST_KV(k2, v2), TEST_KV(k3, v3), TEST_KV(k4, v4))
+#define TEST_KV_LOG_5(level, event, k1, v1, k2, v2, k3, v3, k4, v4, k5, v5) \
+    TEST_KV_EMIT(level, event, TEST_KV(k1, v1), TEST_KV(k2, v2), TEST_KV(k3, v3), TEST_KV(k4, v4), \
+                 TEST_KV(k5, v5))
+#define TEST_KV_LOG_6(level, event, k1, v1, k2, v2, k3, v3, k4, v4, k5, v5, k6, v6) \
+    TEST_KV_EMIT(level, event, TEST_KV(k1, v1), TEST_KV(k2, v2), TEST_KV(k3, v3), TEST_KV(k4, v4), \
+                 TEST_KV(k5, v5), TEST_KV(k6, v6))
+#define TEST_KV_LOG_7(level, event, k1, v1, k2, v2, k3, v3, k4, v4, k5, v5, k6, v6, k7, v7) \
+    TEST_KV_EMIT(level, event, TEST_KV(k1, v1), TEST_KV(k2, v2), TEST_KV(k3, v3), TEST_KV(k4, v4), \
+                 TEST_KV(k5, v5), TEST_KV(k6, v6), TEST_KV(k7, v7))
+#define TEST_KV_LOG_8(level, event, k1, v1, k2, v2, k3, v3, k4, v4, k5, v5, k6, v6, k7, v7, k8, v8) \
+    TEST_KV_EMIT(level, event, TEST_KV(k1, v1), TEST_KV(k2, v2), TEST_KV(k3, v3), TEST_KV(k4, v4), \
+                 TEST_KV(k5, v5), TEST_KV(k6, v6), TEST_KV(k7, v7), TEST_KV(k8, v8))
+
+/* TEST_LOG_KV(level, event, key, value, ...); an odd pair count fails as TEST_KV_LOG_odd */
+#define TEST_LOG_KV(level, ...) \
+    TEST_KV_CAT(TEST_KV_LOG_, TEST_KV_PAIRS(__VA_ARGS__))(level, __VA_ARGS__)
+
+#endif
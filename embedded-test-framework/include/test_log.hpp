@@ -0,0 +1,327 @@
+#ifndef TEST_LOG_HPP
+#define TEST_LOG_HPP
+
+/*
+ * Type-checked C++17 front end for the RTT logger (header only).
+ *
+ * Including this header from C++ turns TEST_LOG_ERROR/WARN/INFO/DEBUG and
+ * TEST_LOG_SAMPLED into checked calls: the format string must be a literal, it is parsed at compile
+ * time, and each argument is checked against its conversion:
+ *
+ *   d i        signed integer, or unsigned narrower than int
+ *   u x X o    unsigned integer
+ *   c          integer no wider than int
+ *   s          char pointer or array
+ *   p          any pointer
+ *   *          width/precision, integer no wider than int
+ *
+ * Integers may be narrower than the length modifier allows but not wider,
+ * so "%ld" takes an int32_t on both the target and the host. Floating-point
+ * conversions and arguments are rejected (test_format() has no float support).
+ * A mismatch fails the build with a static_assert naming the problem.
+ *
+ * Arguments are stored in a fixed-size test_log_record_t (up to
+ * TEST_LOG_MAX_ARGS) and passed to test_log_record(), which formats them with
+ * test_format_args(); no va_list is involved. C files keep using test_log().
+ */
+
+#include "test_rtt_logger.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace test_rtt {
+namespace detail {
+
+enum class arg_kind : std::uint8_t {
+    none,
+    signed_int,
+    unsigned_int,
+    character,
+    string,
+    pointer,
+    star
+};
+
+enum class format_error {
+    none,
+    unknown_conversion,
+    floating_point,
+    type_mismatch,
+    too_wide
+};
+
+/* One argument the format consumes: its kind and, for integers, the widest size it takes */
+struct conversion {
+    arg_kind kind;
+    std::size_t size;
+};
+
+struct parse_result {
+    std::size_t count;
+    format_error error;
+};
+
+constexpr std::size_t length_size(int longs, char modifier) {
+    if (modifier == 'z') {
+        return sizeof(std::size_t);
+    }
+    if (modifier == 'j') {
+        return sizeof(std::intmax_t);
+    }
+    if (modifier == 't') {
+        return sizeof(std::ptrdiff_t);
+    }
+    return longs >= 2 ? sizeof(long long) : longs == 1 ? sizeof(long) : sizeof(int);
+}
+
+/* Walks the format, counting the arguments it consumes; stores conversion 'index' in *found */
+constexpr parse_result parse(const char* format, std::size_t index, conversion* found) {
+    parse_result result = { 0, format_error::none };
+
+    while (*format != '\0') {
+        if (*format++ != '%') {
+            continue;
+        }
+        while (*format == '-' || *format == '0' || *format == '+' || *format == ' ') {
+            format++;
+        }
+        if (*format == '*') {
+            if (result.count++ == index) {
+                *found = { arg_kind::star, sizeof(int) };
+            }
+            format++;
+        }
+        while (*format >= '0' && *format <= '9') {
+            format++;
+        }
+        if (*format == '.') {
+            format++;
+            if (*format == '*') {
+                if (result.count++ == index) {
+                    *found = { arg_kind::star, sizeof(int) };
+                }
+                format++;
+            }
+            while (*format >= '0' && *format <= '9') {
+                format++;
+            }
+        }
+
+        int longs = 0;
+        char modifier = 0;
+        while (*format == 'l' || *format == 'h' || *format == 'z' || *format == 'j' || *format == 't') {
+            if (*format == 'l') {
+                longs++;
+            } else if (*format != 'h') {
+                modifier = *format;
+            }
+            format++;
+        }
+
+        arg_kind kind = arg_kind::none;
+        switch (*format) {
+            case 'd':
+            case 'i':
+                kind = arg_kind::signed_int;
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                kind = arg_kind::unsigned_int;
+                break;
+            case 'c':
+                kind = arg_kind::character;
+                break;
+            case 's':
+                kind = arg_kind::string;
+                break;
+            case 'p':
+                kind = arg_kind::pointer;
+                break;
+            case '%':
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                result.error = format_error::floating_point;
+                return result;
+            default:
+                result.error = format_error::unknown_conversion;
+                return result;
+        }
+        format++;
+
+        if (kind != arg_kind::none) {
+            if (result.count++ == index) {
+                *found = { kind, length_size(longs, modifier) };
+            }
+        }
+    }
+    return result;
+}
+
+template <typename Format>
+constexpr parse_result parse_format() {
+    conversion unused = { arg_kind::none, 0 };
+    return parse(Format::value(), static_cast<std::size_t>(-1), &unused);
+}
+
+template <typename Format>
+constexpr conversion conversion_at(std::size_t index) {
+    conversion found = { arg_kind::none, 0 };
+    parse(Format::value(), index, &found);
+    return found;
+}
+
+template <typename T>
+constexpr bool is_integer = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+template <typename T>
+constexpr format_error check_arg(conversion c) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return format_error::floating_point;
+    } else if constexpr (is_integer<T>) {
+        switch (c.kind) {
+            case arg_kind::signed_int:
+                if (std::is_unsigned_v<T> && sizeof(T) >= sizeof(int)) {
+                    return format_error::type_mismatch;
+                }
+                return sizeof(T) <= c.size ? format_error::none : format_error::too_wide;
+            case arg_kind::unsigned_int:
+                if (std::is_signed_v<T>) {
+                    return format_error::type_mismatch;
+                }
+                return sizeof(T) <= c.size ? format_error::none : format_error::too_wide;
+            case arg_kind::character:
+            case arg_kind::star:
+                return sizeof(T) <= sizeof(int) ? format_error::none : format_error::too_wide;
+            default:
+                return format_error::type_mismatch;
+        }
+    } else if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+        return c.kind == arg_kind::string || c.kind == arg_kind::pointer ? format_error::none
+                                                                         : format_error::type_mismatch;
+    } else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) {
+        return c.kind == arg_kind::pointer ? format_error::none : format_error::type_mismatch;
+    } else {
+        return format_error::type_mismatch;
+    }
+}
+
+template <typename Format, typename... Args, std::size_t... I>
+constexpr format_error check_args(std::index_sequence<I...>) {
+    const format_error errors[] = { format_error::none, check_arg<std::decay_t<Args>>(conversion_at<Format>(I))... };
+    for (format_error error : errors) {
+        if (error != format_error::none) {
+            return error;
+        }
+    }
+    return format_error::none;
+}
+
+template <arg_kind Kind, typename T>
+inline test_format_arg_t make_arg(const T& value) {
+    test_format_arg_t arg = {};
+    if constexpr (Kind == arg_kind::unsigned_int) {
+        arg.u = static_cast<std::uint64_t>(value);
+    } else if constexpr (Kind == arg_kind::string) {
+        arg.s = value;
+    } else if constexpr (Kind == arg_kind::pointer) {
+        arg.p = (const void*)value;
+    } else if constexpr (is_integer<std::decay_t<T>>) {
+        arg.i = static_cast<std::int64_t>(value);
+    }
+    return arg;
+}
+
+template <typename Format, typename... Args, std::size_t... I>
+inline void write(test_log_site_t* site, test_log_sampler_t* sampler, int level, std::index_sequence<I...>,
+                  const Args&... args) {
+    const test_log_record_t record = {
+        Format::value(),
+        site,
+        sampler,
+        static_cast<std::uint8_t>(level),
+        static_cast<std::uint8_t>(sizeof...(Args)),
+        { make_arg<conversion_at<Format>(I).kind>(args)... }
+    };
+    test_log_record(&record);
+}
+
+} // namespace detail
+
+/* format is Format::value() again, so the macros need no empty-__VA_ARGS__ extension */
+template <typename Format, typename... Args>
+inline void log(test_log_site_t* site, test_log_sampler_t* sampler, int level, const char* format,
+                const Args&... args) {
+    using detail::format_error;
+
+    constexpr detail::parse_result parsed = detail::parse_format<Format>();
+    static_assert(parsed.error != format_error::floating_point,
+                  "TEST_LOG: floating-point conversions are not supported, log a scaled integer");
+    static_assert(parsed.error != format_error::unknown_conversion,
+                  "TEST_LOG: unknown conversion in format string");
+    static_assert(parsed.count == sizeof...(Args),
+                  "TEST_LOG: argument count does not match the format string");
+    static_assert(sizeof...(Args) <= TEST_LOG_MAX_ARGS,
+                  "TEST_LOG: more arguments than TEST_LOG_MAX_ARGS");
+
+    constexpr format_error error = detail::check_args<Format, Args...>(std::index_sequence_for<Args...>{});
+    static_assert(error != format_error::floating_point,
+                  "TEST_LOG: floating-point argument, log a scaled integer");
+    static_assert(error != format_error::too_wide,
+                  "TEST_LOG: integer argument is wider than its conversion's length modifier");
+    static_assert(error != format_error::type_mismatch,
+                  "TEST_LOG: argument type does not match its conversion");
+
+    (void)format;
+    detail::write<Format>(site, sampler, level, std::index_sequence_for<Args...>{}, args...);
+}
+
+} // namespace test_rtt
+
+/* The format becomes a constexpr function of a local type so templates can parse it */
+#define TEST_LOG_FORMAT_(format, ...) format
+
+#define TEST_LOG_CHECKED(level, ...) \
+    do { \
+        struct test_log_format_ { \
+            static constexpr const char* value() { return TEST_LOG_FORMAT_(__VA_ARGS__, 0); } \
+        }; \
+        static test_log_site_t test_log_site_ = TEST_LOG_SITE_INIT; \
+        ::test_rtt::log<test_log_format_>(&test_log_site_, nullptr, level, __VA_ARGS__); \
+    } while (0)
+
+#define TEST_LOG_CHECKED_SAMPLED(level, n, ...) \
+    do { \
+        struct test_log_format_ { \
+            static constexpr const char* value() { return TEST_LOG_FORMAT_(__VA_ARGS__, 0); } \
+        }; \
+        static test_log_sampler_t test_log_sampler_ = TEST_LOG_SAMPLER_INIT; \
+        if (test_log_sample(&test_log_sampler_, n)) { \
+            ::test_rtt::log<test_log_format_>(&test_log_sampler_.site, &test_log_sampler_, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#undef TEST_LOG_ERROR
+#undef TEST_LOG_WARN
+#undef TEST_LOG_INFO
+#undef TEST_LOG_DEBUG
+#undef TEST_LOG_SAMPLED
+
+#define TEST_LOG_ERROR(...)   TEST_LOG_CHECKED(TEST_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define TEST_LOG_WARN(...)    TEST_LOG_CHECKED(TEST_LOG_LEVEL_WARN, __VA_ARGS__)
+#define TEST_LOG_INFO(...)    TEST_LOG_CHECKED(TEST_LOG_LEVEL_INFO, __VA_ARGS__)
+#define TEST_LOG_DEBUG(...)   TEST_LOG_CHECKED(TEST_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define TEST_LOG_SAMPLED(level, n, ...) TEST_LOG_CHECKED_SAMPLED(level, n, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef TEST_LOGZ_H
+#define TEST_LOGZ_H
+
+#include "test_format.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Compressed log lines (make COMPRESS=1).
+ *
+ * Log lines go to RTT channel RTT_CHANNEL_LOGZ as binary records instead of
+ * text on channel 0, and their format is never expanded on the target:
+ *
+ *   0x20                               stream start: timestamps restart from 0
+ *   0x10 [id] [length] [bytes]         dictionary slot id now holds this format
+ *   0x0L [dt] [cost] [id] [args...]    one line at level L (bits 0-1); [cost]
+ *                                      is only there when bit 2 is set (LATENCY=1)
+ *
+ * Numbers are LEB128 varints. dt is the cycle count since the previous line,
+ * wrapping at 32 bits. Signed arguments (d i c and '*') are zigzag coded,
+ * unsigned ones and pointers sent as they are, %s as a length and its bytes,
+ * and floating-point conversions send nothing. The level in the header stands
+ * for the "[timestamp] [LEVEL] " prefix of the text line. Each format string
+ * is sent once, then referred to by its slot in a TEST_LOGZ_DICT_SIZE entry
+ * table keyed by the string's address. Lines that do not fit the table or
+ * the channel, and sampled lines, are written to channel 0 as text.
+ * rtt_monitor.py --compressed-log decodes the channel back into text lines as
+ * it arrives.
+ *
+ * test_logz_encode() builds the body (slot and arguments) so the logger can
+ * hash it for repeat suppression; test_logz_send() adds the header, defines
+ * the format if needed and writes the record.
+ */
+
+#ifndef TEST_LOG_COMPRESS
+#define TEST_LOG_COMPRESS 0
+#endif
+
+#ifndef RTT_BUFFER_LOGZ_SIZE
+#define RTT_BUFFER_LOGZ_SIZE 1024
+#endif
+
+/* Power of two, at most 128 so slot ids stay one byte */
+#ifndef TEST_LOGZ_DICT_SIZE
+#define TEST_LOGZ_DICT_SIZE 64u
+#endif
+
+/* Encoded arguments per line; longer strings are cut to fit */
+#ifndef TEST_LOGZ_BODY_MAX
+#define TEST_LOGZ_BODY_MAX 96u
+#endif
+
+#define TEST_LOGZ_START   0x20u
+#define TEST_LOGZ_DEFINE  0x10u
+#define TEST_LOGZ_COST    0x04u
+
+/* Header byte plus two 32-bit varints */
+#define TEST_LOGZ_HEADER_MAX 11u
+
+/* One line: the body is encoded first, the header goes in front of it when sent */
+typedef struct {
+    uint8_t data[TEST_LOGZ_HEADER_MAX + TEST_LOGZ_BODY_MAX];
+    size_t used;
+    const char* format;
+    uint8_t slot;
+    bool defined;
+} test_logz_record_t;
+
+#if TEST_LOG_COMPRESS
+void test_logz_init(void);
+bool test_logz_encode(test_logz_record_t* record, const char* format,
+                      const test_format_arg_t* args, size_t count);
+bool test_logz_send(test_logz_record_t* record, int level, uint32_t timestamp, uint32_t cost);
+void test_logz_report(void);
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef TEST_METRICS_H
+#define TEST_METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * On-target metrics: counters, gauges and log-linear latency histograms.
+ * Recording is O(1) and touches only static RAM; nothing is sent over RTT
+ * until test_metrics_snapshot() runs (on demand, at test end, or at each
+ * soak snapshot). Recording is not atomic; record a metric from one context.
+ * test_metrics_reset() zeroes every registered metric; test_result() calls it
+ * after the per-test snapshot, so each test's scope covers that test only.
+ * A gauge not set since the last reset is left out of the snapshot.
+ */
+
+#ifndef TEST_METRICS_MAX
+#define TEST_METRICS_MAX 32
+#endif
+
+/* Sub-bucket bits per power of two: 3 gives <= 12.5% relative error */
+#ifndef TEST_HIST_SUB_BITS
+#define TEST_HIST_SUB_BITS 3
+#endif
+
+#define TEST_HIST_SUB_COUNT  (1u << TEST_HIST_SUB_BITS)
+#define TEST_HIST_BUCKETS    ((32 - TEST_HIST_SUB_BITS + 1) * TEST_HIST_SUB_COUNT)
+
+#ifndef TEST_METRICS_SNAPSHOT_ON_RESULT
+#define TEST_METRICS_SNAPSHOT_ON_RESULT 1
+#endif
+
+#define TEST_METRIC_COUNTER    'C'
+#define TEST_METRIC_GAUGE      'G'
+#define TEST_METRIC_HISTOGRAM  'H'
+
+typedef struct {
+    const char* name;
+    char type;
+    bool registered;
+} test_metric_t;
+
+typedef struct {
+    test_metric_t base;
+    uint32_t value;
+} test_counter_t;
+
+typedef struct {
+    test_metric_t base;
+    int32_t value;
+    int32_t min;
+    int32_t max;
+    bool set;
+} test_gauge_t;
+
+typedef struct {
+    test_metric_t base;
+    uint32_t count;
+    uint64_t sum;
+    uint32_t min;
+    uint32_t max;
+    uint32_t buckets[TEST_HIST_BUCKETS];
+} test_histogram_t;
+
+#define TEST_COUNTER_DEFINE(var, name) \
+    test_counter_t var = { { name, TEST_METRIC_COUNTER, false }, 0 }
+#define TEST_GAUGE_DEFINE(var, name) \
+    test_gauge_t var = { { name, TEST_METRIC_GAUGE, false }, 0, INT32_MAX, INT32_MIN, false }
+#define TEST_HISTOGRAM_DEFINE(var, name) \
+    test_histogram_t var = { { name, TEST_METRIC_HISTOGRAM, false }, 0, 0, UINT32_MAX, 0, { 0 } }
+
+void test_metrics_register(test_metric_t* metric);
+void test_metrics_snapshot(const char* scope);
+void test_metrics_reset(void);
+
+static inline uint32_t test_hist_bucket(uint32_t value) {
+    if (value < TEST_HIST_SUB_COUNT) {
+        return value;
+    }
+    uint32_t exponent = 31u - (uint32_t)__builtin_clz(value);
+    uint32_t shift = exponent - TEST_HIST_SUB_BITS;
+    return ((shift + 1u) << TEST_HIST_SUB_BITS) | ((value >> shift) & (TEST_HIST_SUB_COUNT - 1u));
+}
+
+static inline void test_counter_add(test_counter_t* counter, uint32_t n) {
+    if (!counter->base.registered) {
+        test_metrics_register(&counter->base);
+    }
+    counter->value += n;
+}
+
+static inline void test_gauge_set(test_gauge_t* gauge, int32_t value) {
+    if (!gauge->base.registered) {
+        test_metrics_register(&gauge->base);
+    }
+    gauge->value = value;
+    gauge->set = true;
+    if (value < gauge->min) {
+        gauge->min = value;
+    }
+    if (value > gauge->max) {
+        gauge->max = value;
+    }
+}
+
+static inline void test_histogram_record(test_histogram_t* hist, uint32_t value) {
+    if (!hist->base.registered) {
+        test_metrics_register(&hist->base);
+    }
+    hist->count++;
+    hist->sum += value;
+    if (value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->buckets[test_hist_bucket(value)]++;
+}
+
+#define TEST_COUNTER_INC(var)           test_counter_add(&(var), 1)
+#define TEST_COUNTER_ADD(var, n)        test_counter_add(&(var), (n))
+#define TEST_GAUGE_SET(var, v)          test_gauge_set(&(var), (v))
+#define TEST_HISTOGRAM_RECORD(var, v)   test_histogram_record(&(var), (v))
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef TEST_POSTMORTEM_H
+#define TEST_POSTMORTEM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Post-mortem log retention across warm resets (make POSTMORTEM=1).
+ *
+ * Every line test_rtt_write() is given for channel 0 is also copied into a
+ * ring of TEST_POSTMORTEM_SIZE bytes in the .noinit section, whether the
+ * channel took it or not. Startup code neither loads nor zeroes .noinit, so
+ * the ring outlives a watchdog, NVIC_SystemReset() or a debugger reset. Its
+ * header holds a magic value, the ring size, a boot count, the number of
+ * bytes ever written and whether test_summary() finished, all covered by a
+ * CRC-32. Line bytes are stored before the header is updated, so a reset in
+ * the middle of a line loses at most that line.
+ *
+ * test_rtt_init() checks the ring before it writes anything else. A session
+ * that was cut short is sent first:
+ *
+ *   POSTMORTEM:BEGIN:<boot>:<bytes kept>:<bytes overwritten>
+ *   PM:<line>                          oldest first, as it was written
+ *   POSTMORTEM:END:<lines>
+ *
+ * A session that reached the end of test_summary() sends
+ * POSTMORTEM:CLEAN:<boot> instead, even if it logged more afterwards.
+ * Power-on RAM fails the check and sends POSTMORTEM:COLD, a header whose CRC
+ * does not match POSTMORTEM:CORRUPT. Either way the ring then restarts for
+ * the new boot.
+ * Compressed lines (COMPRESS=1) and deferred lines still queued (DEFER=1)
+ * never reach channel 0 as text, so they are not kept.
+ *
+ * config/noinit.ld adds the NOLOAD .noinit section; the Makefile passes it.
+ * Leave it out if the device linker script already has one. On the host
+ * build, TEST_NOINIT_FILE names a file that is mapped in place of the
+ * section, so a killed process plays the part of a reset.
+ */
+
+#ifndef TEST_POSTMORTEM_ENABLED
+#define TEST_POSTMORTEM_ENABLED 0
+#endif
+
+/* Power of two */
+#ifndef TEST_POSTMORTEM_SIZE
+#define TEST_POSTMORTEM_SIZE 2048u
+#endif
+
+#define TEST_POSTMORTEM_MAGIC 0x504D4C47u     /* "PMLG" */
+
+#if TEST_POSTMORTEM_ENABLED
+void test_postmortem_init(void);
+void test_postmortem_record(const char* data, unsigned length);
+void test_postmortem_complete(void);
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef TEST_PROFILER_H
+#define TEST_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Statistical PC-sampling profiler (make PROFILE=1).
+ *
+ * A periodic interrupt records the interrupted PC, and optionally LR, into
+ * static RAM; test_profiler_drain() sends the samples as 12-byte records
+ * [pc:4][lr:4][count:4] on RTT channel RTT_CHANNEL_PROFILE. On target the
+ * sampling interrupt is SysTick unless TEST_PROFILER_USE_SYSTICK is 0, in
+ * which case the application calls test_profiler_sample() from its own timer
+ * handler with the exception stack frame. Host builds sample with SIGPROF.
+ * The SysTick handler replaces the HAL's, so it calls HAL_IncTick() (when
+ * linked) once per millisecond at any TEST_PROFILER_RATE_HZ, a multiple of
+ * 1000; test_profiler_stop() puts back the SysTick setup it found.
+ * scripts/pc_profile.py symbolizes captures and writes folded flamegraph stacks.
+ */
+
+#ifndef TEST_PROFILER_ENABLED
+#define TEST_PROFILER_ENABLED 0
+#endif
+
+#ifndef TEST_PROFILER_RATE_HZ
+#define TEST_PROFILER_RATE_HZ 1000u
+#endif
+
+#ifndef TEST_PROFILER_CAPTURE_LR
+#define TEST_PROFILER_CAPTURE_LR 1
+#endif
+
+/* HISTOGRAM counts distinct (pc, lr) pairs; RING keeps the latest raw samples */
+#define TEST_PROFILER_MODE_HISTOGRAM  0
+#define TEST_PROFILER_MODE_RING       1
+
+#ifndef TEST_PROFILER_MODE
+#define TEST_PROFILER_MODE TEST_PROFILER_MODE_HISTOGRAM
+#endif
+
+/* Histogram slots or ring entries; must be a power of two */
+#ifndef TEST_PROFILER_SLOTS
+#define TEST_PROFILER_SLOTS 256
+#endif
+
+#ifndef TEST_PROFILER_USE_SYSTICK
+#define TEST_PROFILER_USE_SYSTICK 1
+#endif
+
+#ifndef RTT_BUFFER_PROFILE_SIZE
+#define RTT_BUFFER_PROFILE_SIZE 512
+#endif
+
+void test_profiler_init(void);
+void test_profiler_start(void);
+void test_profiler_stop(void);
+void test_profiler_sample(const uint32_t* exception_frame);
+void test_profiler_record(uint32_t pc, uint32_t lr);
+void test_profiler_drain(void);
+
+#endif
@@ -2,23 +2,209 @@
 #define TEST_RTT_LOGGER_H
 
 #include "SEGGER_RTT.h"
+#include "test_format.h"
+#include "test_kv.h"
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifndef TEST_HOST_BUILD
+#define TEST_HOST_BUILD 0
+#endif
+
+#if TEST_HOST_BUILD
+#include <time.h>
+#endif
+
+/* SEGGER_RTT sizes channel 0 from BUFFER_SIZE_UP; keep the two equal */
+#ifndef RTT_BUFFER_UP_SIZE
 #define RTT_BUFFER_UP_SIZE 1024
+#endif
 #define RTT_BUFFER_DOWN_SIZE 16
 
+/* Up channel layout; binary channels need SEGGER_RTT_MAX_NUM_UP_BUFFERS > index */
+#define RTT_CHANNEL_TERMINAL   0
+#define RTT_CHANNEL_TRACE      1
+#define RTT_CHANNEL_FUNC_TRACE 2
+#define RTT_CHANNEL_PROFILE    3
+#define RTT_CHANNEL_COVERAGE   4
+#define RTT_CHANNEL_BULK       5
+#define RTT_CHANNEL_LOGZ       6
+
+#ifndef TEST_REPEAT_COUNT
+#define TEST_REPEAT_COUNT 1
+#endif
+
+/* Host builds count nanoseconds instead of CPU cycles */
+#ifndef TEST_CPU_HZ
+#if TEST_HOST_BUILD
+#define TEST_CPU_HZ 1000000000u
+#else
+#define TEST_CPU_HZ 168000000u
+#endif
+#endif
+
+/* Maximum gap between SYNC records; must stay well below the 2^32-cycle wrap */
+#ifndef TEST_SYNC_INTERVAL_MS
+#define TEST_SYNC_INTERVAL_MS 1000u
+#endif
+
+/* Latency probes: log lines also carry the cycles spent between the
+ * TEST_LOG_* call and the write into the RTT buffer ("[emit+delta]") */
+#ifndef TEST_LATENCY_PROBES
+#define TEST_LATENCY_PROBES 0
+#endif
+
+/* Soak mode: loop the suite forever, aggregate on target, emit periodic snapshots */
+#ifndef TEST_SOAK_MODE
+#define TEST_SOAK_MODE 0
+#endif
+
+#ifndef TEST_SOAK_SNAPSHOT_MS
+#define TEST_SOAK_SNAPSHOT_MS 10000u
+#endif
+
+#ifndef TEST_SOAK_MAX_TESTS
+#define TEST_SOAK_MAX_TESTS 16
+#endif
+
+#define TEST_SOAK_HIST_BUCKETS 32
+
+/* Occupancy telemetry: per-test fill distribution of the terminal up buffer,
+ * measured at each log/status/result write as bytes queued plus bytes written */
+#ifndef TEST_OCCUPANCY_ENABLED
+#define TEST_OCCUPANCY_ENABLED 0
+#endif
+
+#define TEST_OCCUPANCY_BUCKETS 16
+
+#ifndef TEST_OCCUPANCY_NEAR_FULL_PCT
+#define TEST_OCCUPANCY_NEAR_FULL_PCT 75u
+#endif
+
 #define TEST_LOG_LEVEL_ERROR   0
 #define TEST_LOG_LEVEL_WARN    1
 #define TEST_LOG_LEVEL_INFO    2
 #define TEST_LOG_LEVEL_DEBUG   3
 
+/* Record classes for test_rtt_write(): the log levels plus protocol records */
+#define TEST_RECORD_CONTROL    4
+#define TEST_RECORD_CLASSES    5
+
+/* Per-class write policies on channel 0 */
+#define TEST_WRITE_BLOCK       0    /* spin until the line fits, up to block_timeout_ms */
+#define TEST_WRITE_TRIM        1    /* cut the line to the free space, ending it "...\r\n" */
+#define TEST_WRITE_DROP        2    /* write whole lines only */
+
+#ifndef TEST_WRITE_BLOCK_TIMEOUT_MS
+#define TEST_WRITE_BLOCK_TIMEOUT_MS 100u
+#endif
+
+/* Longest line test_rtt_printf() formats; longer lines are cut */
+#ifndef TEST_WRITE_LINE_MAX
+#define TEST_WRITE_LINE_MAX 512
+#endif
+
+typedef struct {
+    uint8_t policy[TEST_RECORD_CLASSES];    /* indexed by TEST_LOG_LEVEL_* or TEST_RECORD_CONTROL */
+    uint32_t block_timeout_ms;
+} test_write_policy_t;
+
+/* Protocol records and errors block, warnings and info trim, debug drops */
+#define TEST_WRITE_POLICY_DEFAULT \
+    { { TEST_WRITE_BLOCK, TEST_WRITE_TRIM, TEST_WRITE_TRIM, TEST_WRITE_DROP, TEST_WRITE_BLOCK }, \
+      TEST_WRITE_BLOCK_TIMEOUT_MS }
+
 #define TEST_STATUS_INIT       "TEST_INIT"
 #define TEST_STATUS_RUNNING    "TEST_RUNNING"
 #define TEST_STATUS_PASS       "TEST_PASS"
 #define TEST_STATUS_FAIL       "TEST_FAIL"
 #define TEST_STATUS_COMPLETE   "TEST_COMPLETE"
 
+/* Per-callsite rate limit: a token bucket refilled at TEST_LOG_RATE_LIMIT lines/s
+ * holding up to TEST_LOG_RATE_BURST lines; 0 (the default) disables. TEST_CPU_HZ /
+ * rate * burst must fit in 32 bits. Suppressed lines are counted per site (LOGLIMIT
+ * lines). Opt-in: a dropped ERROR line can hide the cause of a failure. */
+#ifndef TEST_LOG_RATE_LIMIT
+#define TEST_LOG_RATE_LIMIT 0u
+#endif
+
+#ifndef TEST_LOG_RATE_BURST
+#define TEST_LOG_RATE_BURST 20u
+#endif
+
+/* Identical consecutive log lines collapse into "last message repeated N times".
+ * Lines are compared by length, hash and their first TEST_LOG_REPEAT_COMPARE bytes. */
+#ifndef TEST_LOG_REPEAT_SUPPRESS
+#define TEST_LOG_REPEAT_SUPPRESS 1
+#endif
+
+#ifndef TEST_LOG_REPEAT_COMPARE
+#define TEST_LOG_REPEAT_COMPARE 64u
+#endif
+
+/* Deferred logging: test_log() only queues the timestamp, format and arguments in
+ * a ring of TEST_LOG_DEFER_DEPTH records (a power of two); test_log_drain(), from
+ * an idle hook or low-priority task, formats and writes them. The framework also
+ * drains before STATUS lines and KV records. Single producer: do not log from
+ * interrupts in this mode, and %s arguments must outlive the queued record. */
+#ifndef TEST_LOG_DEFERRED
+#define TEST_LOG_DEFERRED 0
+#endif
+
+#ifndef TEST_LOG_DEFER_DEPTH
+#define TEST_LOG_DEFER_DEPTH 32u
+#endif
+
+/* One per TEST_LOG_* call site, static in the expanding function */
+typedef struct test_log_site {
+    const char* file;
+    uint32_t line;
+    bool primed;
+    bool listed;
+    uint32_t tokens;                /* bucket fill in cycles; one line costs TEST_CPU_HZ / rate */
+    uint64_t last_cycles;           /* 64-bit, so an idle site survives a counter wrap */
+    uint32_t suppressed;            /* since the last LOGLIMIT report */
+    uint32_t total_suppressed;
+    struct test_log_site* next;     /* sites that have suppressed anything */
+} test_log_site_t;
+
+#define TEST_LOG_SITE_INIT { __FILE__, __LINE__, false, false, 0, 0, 0, 0, NULL }
+
+/* TEST_LOG_SAMPLED(level, n, ...) logs the first of every n calls at its site,
+ * or with TEST_LOG_SAMPLE_RANDOM each call with probability 1/n (xorshift32).
+ * Sampled lines carry "[1/n file:line]" so the host can scale counts back up,
+ * and the summary lists exact calls per site as LOGSAMPLE lines. */
+#ifndef TEST_LOG_SAMPLE_RANDOM
+#define TEST_LOG_SAMPLE_RANDOM 0
+#endif
+
+/* One per TEST_LOG_SAMPLED call site; counts every call, sampled or not */
+typedef struct test_log_sampler {
+    test_log_site_t site;
+    uint32_t calls;
+    uint32_t emitted;
+    uint32_t rate;
+    uint32_t countdown;
+    struct test_log_sampler* next;
+} test_log_sampler_t;
+
+#define TEST_LOG_SAMPLER_INIT { TEST_LOG_SITE_INIT, 0, 0, 0, 0, NULL }
+
+/* Most arguments one test_log_record_t carries */
+#ifndef TEST_LOG_MAX_ARGS
+#define TEST_LOG_MAX_ARGS 8
+#endif
+
+/* A log call with its arguments already serialized, from test_log.hpp */
+typedef struct {
+    const char* format;
+    test_log_site_t* site;
+    test_log_sampler_t* sampler;    /* NULL unless from TEST_LOG_SAMPLED */
+    uint8_t level;
+    uint8_t count;
+    test_format_arg_t args[TEST_LOG_MAX_ARGS];
+} test_log_record_t;
+
 typedef struct {
     const char* name;
     uint32_t test_id;
@@ -27,17 +213,104 @@ typedef struct {
     bool passed;
 } test_case_t;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void test_rtt_init(void);
-void test_log(int level, const char* format, ...);
+void test_rtt_init_with_policy(const test_write_policy_t* policy);
+int test_rtt_write(int record_class, const char* data, unsigned length);
+int test_rtt_printf(int record_class, const char* format, ...) TEST_FORMAT_PRINTF(2, 3);
+void test_log(int level, const char* format, ...) TEST_FORMAT_PRINTF(2, 3);
+void test_log_at(test_log_site_t* site, int level, const char* format, ...) TEST_FORMAT_PRINTF(3, 4);
+void test_log_sampled(test_log_sampler_t* sampler, int level, const char* format, ...) TEST_FORMAT_PRINTF(3, 4);
+void test_log_sampler_register(test_log_sampler_t* sampler);
+void test_log_record(const test_log_record_t* record);
+unsigned test_log_drain(void);
 void test_status(const char* status, const char* test_name);
 void test_result(const char* test_name, bool passed, uint32_t duration_ms);
 void test_assert(bool condition, const char* message);
+void test_run(void (*test_fn)(void));
+void test_clock_sync(void);
+void test_soak_loop(void (*suite_fn)(void));
+void test_soak_snapshot(void);
+
+/* Test between its RUNNING status and its result, or NULL; index counts tests from 1 */
+const char* test_running(uint32_t* index);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* DWT cycle counter, enabled by test_rtt_init(). Wraps every 2^32 cycles. */
+#define TEST_DWT_CTRL    (*(volatile uint32_t*)0xE0001000u)
+#define TEST_DWT_CYCCNT  (*(volatile uint32_t*)0xE0001004u)
+#define TEST_DEMCR       (*(volatile uint32_t*)0xE000EDFCu)
+
+static inline uint32_t test_get_cycles(void) {
+#if TEST_HOST_BUILD
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+#else
+    return TEST_DWT_CYCCNT;
+#endif
+}
 
-#define TEST_LOG_ERROR(...)   test_log(TEST_LOG_LEVEL_ERROR, __VA_ARGS__)
-#define TEST_LOG_WARN(...)    test_log(TEST_LOG_LEVEL_WARN, __VA_ARGS__)
-#define TEST_LOG_INFO(...)    test_log(TEST_LOG_LEVEL_INFO, __VA_ARGS__)
-#define TEST_LOG_DEBUG(...)   test_log(TEST_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define TEST_LOG_SITE(level, ...) \
+    do { \
+        static test_log_site_t test_log_site_ = TEST_LOG_SITE_INIT; \
+        test_log_at(&test_log_site_, level, __VA_ARGS__); \
+    } while (0)
+
+#if TEST_LOG_SAMPLE_RANDOM
+#ifdef __cplusplus
+extern "C" uint32_t test_log_sample_state;
+#else
+extern uint32_t test_log_sample_state;
+#endif
+#endif
+
+/* Cheap enough for hot paths: a counter, or an xorshift step and a multiply */
+static inline bool test_log_sample(test_log_sampler_t* sampler, uint32_t n) {
+    if (sampler->calls++ == 0u) {
+        test_log_sampler_register(sampler);
+    }
+    sampler->rate = n;
+    
+#if TEST_LOG_SAMPLE_RANDOM
+    uint32_t x = test_log_sample_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    test_log_sample_state = x;
+    return (uint32_t)(((uint64_t)x * n) >> 32) == 0u;
+#else
+    if (sampler->countdown == 0u) {
+        sampler->countdown = n > 1u ? n - 1u : 0u;
+        return true;
+    }
+    sampler->countdown--;
+    return false;
+#endif
+}
+
+/* Logs 1 in n calls at this site; the line is tagged "[1/n file:line]" for the host */
+#define TEST_LOG_SAMPLED(level, n, ...) \
+    do { \
+        static test_log_sampler_t test_log_sampler_ = TEST_LOG_SAMPLER_INIT; \
+        if (test_log_sample(&test_log_sampler_, n)) { \
+            test_log_sampled(&test_log_sampler_, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define TEST_LOG_ERROR(...)   TEST_LOG_SITE(TEST_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define TEST_LOG_WARN(...)    TEST_LOG_SITE(TEST_LOG_LEVEL_WARN, __VA_ARGS__)
+#define TEST_LOG_INFO(...)    TEST_LOG_SITE(TEST_LOG_LEVEL_INFO, __VA_ARGS__)
+#define TEST_LOG_DEBUG(...)   TEST_LOG_SITE(TEST_LOG_LEVEL_DEBUG, __VA_ARGS__)
 
 #define TEST_ASSERT(cond, msg) test_assert(cond, msg)
 
+#define TEST_RUN(test_fn)     test_run(test_fn)
+
 #endif
\ No newline at end of file
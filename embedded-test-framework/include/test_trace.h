@@ -0,0 +1,55 @@
+#ifndef TEST_TRACE_H
+#define TEST_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Binary event tracing on RTT channel RTT_CHANNEL_TRACE.
+ *
+ * Records are little-endian: [type:1][id:1][cycles:4] with a trailing
+ * [value:4] for counters. A name is sent once as a DEFINE record
+ * [0:1][id:1][len:1][name:len] the first time its pointer is seen, so
+ * names must be string literals or otherwise outlive the trace. After
+ * events are lost (buffer full or, with FLOW=1, no host credit) the next
+ * record is a TEST_TRACE_LOST_NAME counter holding the number lost.
+ * rtt_monitor.py exports captures as Chrome/Perfetto trace JSON.
+ */
+
+#ifndef TEST_TRACE_ENABLED
+#define TEST_TRACE_ENABLED 0
+#endif
+
+#ifndef RTT_BUFFER_TRACE_SIZE
+#define RTT_BUFFER_TRACE_SIZE 1024
+#endif
+
+/* Interned names; must be a power of two and at most 256 */
+#ifndef TEST_TRACE_MAX_NAMES
+#define TEST_TRACE_MAX_NAMES 64
+#endif
+
+#define TEST_TRACE_LOST_NAME "trace.lost"
+
+#define TEST_TRACE_DEFINE   0
+#define TEST_TRACE_BEGIN    1
+#define TEST_TRACE_END      2
+#define TEST_TRACE_INSTANT  3
+#define TEST_TRACE_COUNTER  4
+
+void test_trace_init(void);
+void test_trace_event(uint8_t type, const char* name, int32_t value);
+void test_trace_report(void);
+
+#if TEST_TRACE_ENABLED
+#define TRACE_BEGIN(name)           test_trace_event(TEST_TRACE_BEGIN, (name), 0)
+#define TRACE_END(name)             test_trace_event(TEST_TRACE_END, (name), 0)
+#define TRACE_INSTANT(name)         test_trace_event(TEST_TRACE_INSTANT, (name), 0)
+#define TRACE_COUNTER(name, value)  test_trace_event(TEST_TRACE_COUNTER, (name), (int32_t)(value))
+#else
+#define TRACE_BEGIN(name)           ((void)0)
+#define TRACE_END(name)             ((void)0)
+#define TRACE_INSTANT(name)         ((void)0)
+#define TRACE_COUNTER(name, value)  ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+
+"""Write the test_dump_binary()/test_dump_array() dumps in a bulk channel
+capture (make BULK=1) to .npy or raw files. See include/test_bulk.h for the
+stream format."""
+
+import argparse
+import os
+import re
+import struct
+import sys
+from dataclasses import dataclass
+from typing import List, Tuple
+
+TAG_HEADER = ord('H')
+TAG_DATA = ord('D')
+TAG_END = ord('E')
+
+FLAG_DELTA = 0x01
+FLAG_RLE = 0x02
+
+# TEST_BULK_* element types: (numpy descr, size)
+ELEMENT_TYPES = {
+    0: ('|u1', 1),
+    1: ('|i1', 1),
+    2: ('<u2', 2),
+    3: ('<i2', 2),
+    4: ('<u4', 4),
+    5: ('<i4', 4),
+    6: ('<f4', 4),
+}
+
+class BulkStreamError(Exception):
+    pass
+
+@dataclass
+class Dump:
+    name: str
+    sequence: int
+    element_type: int
+    flags: int
+    count: int
+    data: bytes
+    encoded_bytes: int
+
+    @property
+    def descr(self) -> str:
+        return ELEMENT_TYPES[self.element_type][0]
+
+def rle_decode(data: bytes) -> bytes:
+    out = bytearray()
+    offset = 0
+    while offset < len(data):
+        control = data[offset]
+        offset += 1
+        if control < 0x80:
+            literal = data[offset:offset + control + 1]
+            if len(literal) != control + 1:
+                raise BulkStreamError("RLE literal runs past the end of the dump")
+            out += literal
+            offset += control + 1
+        else:
+            if offset >= len(data):
+                raise BulkStreamError("RLE run without its byte")
+            out += bytes([data[offset]]) * (control - 0x80 + 3)
+            offset += 1
+    return bytes(out)
+
+def delta_decode(data: bytes, size: int) -> bytes:
+    mask = (1 << (8 * size)) - 1
+    out = bytearray(len(data))
+    previous = 0
+    for offset in range(0, len(data) - len(data) % size, size):
+        previous = (previous + int.from_bytes(data[offset:offset + size], 'little')) & mask
+        out[offset:offset + size] = previous.to_bytes(size, 'little')
+    return bytes(out)
+
+def decode_stream(data: bytes) -> Tuple[List[Dump], List[str]]:
+    """Complete dumps, and the names of dumps the target cut short (no 'E' frame)"""
+    dumps = []
+    cut = []
+    header = None
+    payload = bytearray()
+    offset = 0
+
+    while offset + 5 <= len(data):
+        tag = data[offset]
+        length, = struct.unpack_from('<I', data, offset + 1)
+        frame = data[offset + 5:offset + 5 + length]
+        if len(frame) != length:
+            raise BulkStreamError(f"truncated frame at offset {offset}")
+        offset += 5 + length
+
+        if tag == TAG_HEADER:
+            if header is not None:
+                cut.append(f"{header[1]} ({header[0]})")
+            element_type, flags, count, sequence = struct.unpack_from('<BBII', frame)
+            if element_type not in ELEMENT_TYPES:
+                raise BulkStreamError(f"unknown element type {element_type} in dump {sequence}")
+            name = frame[10:].decode('utf-8', errors='replace')
+            header = (name, sequence, element_type, flags, count)
+            payload = bytearray()
+        elif tag == TAG_DATA:
+            if header is None:
+                raise BulkStreamError(f"data before a dump header at offset {offset}")
+            payload += frame
+        elif tag == TAG_END:
+            if header is None:
+                raise BulkStreamError(f"end frame without a dump at offset {offset}")
+            raw_bytes, encoded_bytes = struct.unpack('<II', frame)
+            name, sequence, element_type, flags, count = header
+            size = ELEMENT_TYPES[element_type][1]
+
+            raw = bytes(payload)
+            if flags & FLAG_RLE:
+                raw = rle_decode(raw)
+            if flags & FLAG_DELTA:
+                raw = delta_decode(raw, size)
+            if len(payload) != encoded_bytes or len(raw) != raw_bytes or raw_bytes != count * size:
+                raise BulkStreamError(f"dump {sequence} ({name}): {len(raw)} bytes decoded, "
+                                      f"target sent {raw_bytes}")
+
+            dumps.append(Dump(name, sequence, element_type, flags, count, raw, encoded_bytes))
+            header = None
+        else:
+            raise BulkStreamError(f"unknown tag 0x{tag:02x} at offset {offset}")
+
+    if header is not None:
+        cut.append(f"{header[1]} ({header[0]})")
+    return dumps, cut
+
+def npy_bytes(dump: Dump) -> bytes:
+    """NPY format 1.0 for a 1-D array, without needing numpy"""
+    header = f"{{'descr': '{dump.descr}', 'fortran_order': False, 'shape': ({dump.count},), }}"
+    # Magic, version and length take 10 bytes; pad so the data starts 64-byte aligned
+    padding = 64 - (10 + len(header) + 1) % 64
+    header = header + ' ' * (padding % 64) + '\n'
+    return b'\x93NUMPY\x01\x00' + struct.pack('<H', len(header)) + header.encode('latin1') + dump.data
+
+def file_name(dump: Dump, extension: str) -> str:
+    safe = re.sub(r'[^A-Za-z0-9_.-]+', '_', dump.name).strip('_') or "dump"
+    return f"{dump.sequence:04d}_{safe}{extension}"
+
+def write_dumps(dumps: List[Dump], output_dir: str, raw: bool) -> List[str]:
+    os.makedirs(output_dir, exist_ok=True)
+    written = []
+    for dump in dumps:
+        path = os.path.join(output_dir, file_name(dump, ".bin" if raw else ".npy"))
+        with open(path, 'wb') as f:
+            f.write(dump.data if raw else npy_bytes(dump))
+        written.append(path)
+    return written
+
+def read_npy(path: str) -> Tuple[str, bytes]:
+    """Element descr and data of a file written by npy_bytes()"""
+    with open(path, 'rb') as f:
+        content = f.read()
+    if content[:8] != b'\x93NUMPY\x01\x00':
+        raise BulkStreamError(f"{path}: not an NPY 1.0 file")
+    header_length, = struct.unpack_from('<H', content, 8)
+    header = content[10:10 + header_length].decode('latin1')
+    descr = re.search(r"'descr': '([^']+)'", header)
+    if descr is None:
+        raise BulkStreamError(f"{path}: no descr in the NPY header")
+    return descr.group(1), content[10 + header_length:]
+
+def check_matches(dumps: List[Dump], written: List[str], pairs: List[str]) -> List[str]:
+    """For each A=B, the files written for dumps A and B must hold the same elements"""
+    files = {dump.name: path for dump, path in zip(dumps, written)}
+    errors = []
+    for pair in pairs:
+        first, _, second = pair.partition('=')
+        missing = [name for name in (first, second) if name not in files]
+        if missing:
+            errors.append(f"{pair}: no complete dump named {', '.join(missing)}")
+            continue
+        if files[first].endswith('.npy'):
+            a, b = read_npy(files[first]), read_npy(files[second])
+        else:
+            with open(files[first], 'rb') as fa, open(files[second], 'rb') as fb:
+                a, b = fa.read(), fb.read()
+        if a != b:
+            errors.append(f"{pair}: the decoded dumps differ")
+    return errors
+
+def main():
+    parser = argparse.ArgumentParser(description="Write bulk sample dumps captured over RTT to files")
+    parser.add_argument("capture", help="Binary capture of RTT channel 5")
+    parser.add_argument("--output-dir", default="bulk", help="Directory for the dump files")
+    parser.add_argument("--raw", action="store_true", help="Write raw little-endian bytes instead of .npy")
+    parser.add_argument("--match", action="append", default=[], metavar="A=B",
+                        help="Fail unless dumps A and B decode to the same elements (repeatable)")
+    args = parser.parse_args()
+
+    try:
+        with open(args.capture, 'rb') as f:
+            dumps, cut = decode_stream(f.read())
+        written = write_dumps(dumps, args.output_dir, args.raw)
+        mismatches = check_matches(dumps, written, args.match)
+    except (BulkStreamError, OSError) as e:
+        print(f"[BULK] ERROR: {e}")
+        return 1
+
+    for dump, path in zip(dumps, written):
+        ratio = dump.encoded_bytes / len(dump.data) if dump.data else 1.0
+        print(f"[BULK] {path}: {dump.count} x {dump.descr}, {len(dump.data)} bytes "
+              f"({dump.encoded_bytes} sent, {ratio:.2f})")
+    for name in cut:
+        print(f"[BULK] WARNING: dump {name} was cut short on the target, skipped")
+    print(f"[BULK] {len(written)} dumps written")
+
+    for mismatch in mismatches:
+        print(f"[BULK] ERROR: {mismatch}")
+    if args.match and not mismatches:
+        print(f"[BULK] {len(args.match)} dump pairs match")
+    return 1 if mismatches else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
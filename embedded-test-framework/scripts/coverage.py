@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+
+"""Rebuild .gcda files from a coverage channel capture (make COVERAGE=1) and
+merge them across runs with gcov-tool. See include/test_coverage.h for the
+stream format."""
+
+import argparse
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+from typing import Dict, List
+
+TAG_FILE = ord('F')
+TAG_DATA = ord('D')
+TAG_END = ord('E')
+
+class CoverageStreamError(Exception):
+    pass
+
+def decode_stream(data: bytes) -> Dict[str, bytes]:
+    """Split a capture into {recorded .gcda path: contents}"""
+    files: Dict[str, bytearray] = {}
+    current = None
+    offset = 0
+    expected_files = None
+
+    while offset + 5 <= len(data):
+        tag = data[offset]
+        length, = struct.unpack_from('<I', data, offset + 1)
+        payload = data[offset + 5:offset + 5 + length]
+        if len(payload) != length:
+            raise CoverageStreamError(f"truncated frame at offset {offset}")
+        offset += 5 + length
+
+        if tag == TAG_FILE:
+            current = payload.decode('utf-8', errors='replace')
+            files[current] = bytearray()
+        elif tag == TAG_DATA:
+            if current is None:
+                raise CoverageStreamError(f"data before file name at offset {offset}")
+            files[current] += payload
+        elif tag == TAG_END:
+            expected_files, = struct.unpack('<I', payload)
+            break
+        else:
+            raise CoverageStreamError(f"unknown tag 0x{tag:02x} at offset {offset}")
+
+    if expected_files is None:
+        raise CoverageStreamError("capture ends before the end-of-dump frame")
+    if expected_files != len(files):
+        raise CoverageStreamError(f"target dumped {expected_files} files, capture has {len(files)}")
+
+    return {name: bytes(contents) for name, contents in files.items()}
+
+def output_path(recorded: str, output_dir: str, strip: int) -> str:
+    """Like GCOV_PREFIX/GCOV_PREFIX_STRIP: drop `strip` leading directories"""
+    if not output_dir:
+        return recorded
+    parts = [p for p in recorded.split('/') if p]
+    return os.path.join(output_dir, *parts[strip:])
+
+def extract(capture: str, output_dir: str, strip: int) -> List[str]:
+    with open(capture, 'rb') as f:
+        files = decode_stream(f.read())
+
+    written = []
+    for recorded, contents in files.items():
+        path = output_path(recorded, output_dir, strip)
+        os.makedirs(os.path.dirname(path) or '.', exist_ok=True)
+        with open(path, 'wb') as f:
+            f.write(contents)
+        written.append(path)
+    return written
+
+def merge(output_dir: str, inputs: List[str], gcov_tool: str):
+    """Fold each input directory into output_dir with `gcov-tool merge`"""
+    if not os.path.isdir(output_dir):
+        shutil.copytree(inputs[0], output_dir)
+        inputs = inputs[1:]
+
+    for directory in inputs:
+        with tempfile.TemporaryDirectory() as merged:
+            # Profiles found in only one of the two inputs are copied as-is
+            subprocess.run([gcov_tool, "merge", "-o", merged, output_dir, directory], check=True)
+            shutil.rmtree(output_dir)
+            shutil.copytree(merged, output_dir)
+
+def main():
+    parser = argparse.ArgumentParser(description="Rebuild and merge gcov data captured over RTT")
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    extract_parser = subparsers.add_parser("extract", help="Write the .gcda files in a capture")
+    extract_parser.add_argument("capture", help="Binary capture of RTT channel 4")
+    extract_parser.add_argument("--output-dir",
+                                help="Write under this directory instead of the recorded paths")
+    extract_parser.add_argument("--strip", type=int, default=0,
+                                help="Leading directories to drop with --output-dir")
+
+    merge_parser = subparsers.add_parser("merge", help="Merge extracted runs or shards")
+    merge_parser.add_argument("output", help="Directory holding the merged .gcda files")
+    merge_parser.add_argument("inputs", nargs="+", help="Directories from 'extract --output-dir'")
+    merge_parser.add_argument("--gcov-tool", default="arm-none-eabi-gcov-tool")
+
+    args = parser.parse_args()
+
+    if args.command == "extract":
+        try:
+            written = extract(args.capture, args.output_dir, args.strip)
+        except (CoverageStreamError, OSError) as e:
+            print(f"[COVERAGE] ERROR: {e}")
+            return 1
+        for path in written:
+            print(f"[COVERAGE] {path}")
+        print(f"[COVERAGE] {len(written)} .gcda files written")
+        return 0
+
+    try:
+        merge(args.output, args.inputs, args.gcov_tool)
+    except (subprocess.CalledProcessError, OSError) as e:
+        print(f"[COVERAGE] ERROR: merge failed: {e}")
+        return 1
+    print(f"[COVERAGE] Merged {len(args.inputs)} runs into {args.output}")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
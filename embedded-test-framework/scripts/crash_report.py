@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+
+"""Decode a crash record (make FAULT=1) and symbolize its backtrace from the
+ELF. Reads the CRASH: line from a monitor log or results JSON, including one
+kept across a reset by POSTMORTEM=1. See include/test_fault.h for the record
+format."""
+
+import argparse
+import json
+import re
+import signal
+import struct
+import subprocess
+import sys
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional
+
+from elf_symbols import ElfSymbols
+
+RECORD_VERSION = 1
+HEADER = struct.Struct('<BBH16I')
+FIELDS = ['r0', 'r1', 'r2', 'r3', 'r12', 'lr', 'pc', 'xpsr', 'sp', 'exc_return',
+          'cfsr', 'hfsr', 'mmfar', 'bfar', 'test_index', 'cycles']
+
+CRASH_PATTERN = re.compile(r'CRASH:([0-9a-f]+):(.*)')
+
+# TEST_FAULT_* kinds: exception numbers, or TEST_FAULT_HOST_SIGNAL | signo
+FAULT_KINDS = {3: 'HardFault', 4: 'MemManage', 5: 'BusFault', 6: 'UsageFault'}
+HOST_SIGNAL = 0x80
+
+CFSR_BITS = {
+    0: 'IACCVIOL', 1: 'DACCVIOL', 3: 'MUNSTKERR', 4: 'MSTKERR', 5: 'MLSPERR', 7: 'MMARVALID',
+    8: 'IBUSERR', 9: 'PRECISERR', 10: 'IMPRECISERR', 11: 'UNSTKERR', 12: 'STKERR',
+    13: 'LSPERR', 15: 'BFARVALID',
+    16: 'UNDEFINSTR', 17: 'INVSTATE', 18: 'INVPC', 19: 'NOCP', 24: 'UNALIGNED', 25: 'DIVBYZERO',
+}
+HFSR_BITS = {1: 'VECTTBL', 30: 'FORCED', 31: 'DEBUGEVT'}
+MMARVALID = 1 << 7
+BFARVALID = 1 << 15
+
+# si_code values for the signals the host build catches
+SI_CODES = {
+    'SIGSEGV': {1: 'SEGV_MAPERR', 2: 'SEGV_ACCERR'},
+    'SIGBUS': {1: 'BUS_ADRALN', 2: 'BUS_ADRERR', 3: 'BUS_OBJERR'},
+    'SIGILL': {1: 'ILL_ILLOPC', 2: 'ILL_ILLOPN', 3: 'ILL_ILLADR', 4: 'ILL_ILLTRP',
+               5: 'ILL_PRVOPC', 6: 'ILL_PRVREG', 7: 'ILL_COPROC', 8: 'ILL_BADSTK'},
+    'SIGFPE': {1: 'FPE_INTDIV', 2: 'FPE_INTOVF', 3: 'FPE_FLTDIV', 4: 'FPE_FLTOVF',
+               5: 'FPE_FLTUND', 6: 'FPE_FLTRES', 7: 'FPE_FLTINV', 8: 'FPE_FLTSUB'},
+}
+
+class CrashRecordError(Exception):
+    pass
+
+def bit_names(value: int, names: Dict[int, str]) -> List[str]:
+    return [name for bit, name in sorted(names.items()) if value & (1 << bit)]
+
+@dataclass
+class Frame:
+    source: str         # pc, lr or stack+<offset>
+    address: int
+    function: Optional[str] = None
+    location: Optional[str] = None
+
+@dataclass
+class CrashRecord:
+    kind: int
+    registers: Dict[str, int]
+    stack: List[int]
+    test_name: str
+    frames: List[Frame] = field(default_factory=list)
+
+    @classmethod
+    def parse(cls, hex_text: str, test_name: str = "") -> 'CrashRecord':
+        data = bytes.fromhex(hex_text)
+        if len(data) < HEADER.size:
+            raise CrashRecordError(f"record is {len(data)} bytes, the header alone is {HEADER.size}")
+        version, kind, stack_words, *values = HEADER.unpack_from(data)
+        if version != RECORD_VERSION:
+            raise CrashRecordError(f"record version {version}, expected {RECORD_VERSION}")
+        if len(data) < HEADER.size + 4 * stack_words:
+            raise CrashRecordError(f"record cut short: {stack_words} stack words announced")
+        stack = list(struct.unpack_from(f'<{stack_words}I', data, HEADER.size))
+        return cls(kind, dict(zip(FIELDS, values)), stack, test_name)
+
+    @property
+    def host(self) -> bool:
+        return bool(self.kind & HOST_SIGNAL)
+
+    @property
+    def kind_name(self) -> str:
+        if self.host:
+            number = self.kind & ~HOST_SIGNAL
+            try:
+                return signal.Signals(number).name
+            except ValueError:
+                return f"signal {number}"
+        return FAULT_KINDS.get(self.kind, f"exception {self.kind}")
+
+    def causes(self) -> List[str]:
+        """Fault status bits by name, with the faulting address when it is valid"""
+        registers = self.registers
+        if self.host:
+            code = SI_CODES.get(self.kind_name, {}).get(registers['cfsr'], f"si_code {registers['cfsr']}")
+            return [f"{code} at 0x{registers['mmfar']:08x}"]
+
+        causes = bit_names(registers['hfsr'], HFSR_BITS)
+        for name in bit_names(registers['cfsr'], CFSR_BITS):
+            if name == 'MMARVALID':
+                causes.append(f"MMFAR 0x{registers['mmfar']:08x}")
+            elif name == 'BFARVALID':
+                causes.append(f"BFAR 0x{registers['bfar']:08x}")
+            else:
+                causes.append(name)
+        return causes
+
+    def candidates(self, symbols: ElfSymbols) -> List[Frame]:
+        """PC, LR, then stack words that look like return addresses into code
+
+        There are no frame pointers to follow, so stack words are only
+        candidates: a stale return address left by an earlier call looks the
+        same as a live one.
+        """
+        registers = self.registers
+        frames = [Frame('pc', registers['pc'])]
+        # 0xFxxxxxxx in LR is an EXC_RETURN value: the fault hit an exception handler
+        if registers['lr'] and registers['lr'] < 0xF0000000:
+            frames.append(Frame('lr', registers['lr']))
+        for index, word in enumerate(self.stack):
+            # Thumb return addresses are odd; the host stack holds 64-bit words, split in two
+            if (self.host or word & 1) and symbols.contains(word):
+                frames.append(Frame(f"stack+0x{4 * index:x}", word))
+        return frames
+
+    def symbolize(self, symbols: ElfSymbols):
+        self.frames = []
+        for frame in self.candidates(symbols):
+            if self.frames and self.frames[-1].address == frame.address:
+                continue
+            frame.function = symbols.lookup(frame.address)
+            # A return address points after the call; the call itself is on the line before
+            lookup = frame.address if frame.source == 'pc' else (frame.address & ~1) - 1
+            frame.location = symbols.source_line(lookup)
+            self.frames.append(frame)
+
+    def print_report(self, prefix: str = "[CRASH]"):
+        registers = self.registers
+        where = f"in test {registers['test_index']} '{self.test_name}'" if self.test_name else "outside a test"
+        causes = ', '.join(self.causes()) or 'no status bits set'
+        print(f"{prefix} {self.kind_name} {where}: {causes}")
+        print(f"  pc 0x{registers['pc']:08x}  lr 0x{registers['lr']:08x}  "
+              f"sp 0x{registers['sp']:08x}  xpsr 0x{registers['xpsr']:08x}")
+        print(f"  r0 0x{registers['r0']:08x}  r1 0x{registers['r1']:08x}  "
+              f"r2 0x{registers['r2']:08x}  r3 0x{registers['r3']:08x}  r12 0x{registers['r12']:08x}")
+        if not self.host:
+            print(f"  cfsr 0x{registers['cfsr']:08x}  hfsr 0x{registers['hfsr']:08x}  "
+                  f"exc_return 0x{registers['exc_return']:08x}")
+        for frame in self.frames:
+            print(f"  {frame.source:>10} 0x{frame.address:08x} {frame.function} ({frame.location or '?'})")
+        if not self.frames and self.stack:
+            words = ' '.join(f"{word:08x}" for word in self.stack)
+            print(f"  stack: {words}")
+
+    def to_dict(self) -> dict:
+        return {
+            'kind': self.kind_name,
+            'test': self.test_name or None,
+            'causes': self.causes(),
+            'registers': self.registers,
+            'stack': self.stack,
+            'backtrace': [{'source': f.source, 'address': f.address, 'function': f.function,
+                           'location': f.location} for f in self.frames]
+        }
+
+def load_symbols(elf: Optional[str], toolchain_prefix: str) -> Optional[ElfSymbols]:
+    """ElfSymbols for the ELF, or None (with a warning) when binutils cannot read it"""
+    if not elf:
+        return None
+    try:
+        return ElfSymbols(elf, toolchain_prefix)
+    except (OSError, subprocess.CalledProcessError) as e:
+        print(f"[CRASH] WARNING: cannot read symbols from {elf}: {e}")
+        return None
+
+def find_crashes(path: str) -> List[CrashRecord]:
+    """Every CRASH: line in a monitor log or in the log buffer of a results JSON"""
+    with open(path) as f:
+        text = f.read()
+    if path.endswith('.json'):
+        results = json.loads(text)
+        text = '\n'.join(entry['raw'] for entry in results.get('log_buffer', []))
+        text += '\n' + '\n'.join(results.get('postmortem', {}).get('lines', []))
+    return [CrashRecord.parse(hex_text, test_name.strip())
+            for hex_text, test_name in CRASH_PATTERN.findall(text)]
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode and symbolize crash records (make FAULT=1)")
+    parser.add_argument("log", help="Monitor log or results JSON holding CRASH: lines")
+    parser.add_argument("elf", nargs="?", help="Firmware ELF (or host executable) for the backtrace")
+    parser.add_argument("--toolchain-prefix", default="arm-none-eabi-",
+                        help="Binutils prefix; use '' for host builds")
+    parser.add_argument("--json", help="Also write the decoded records as JSON")
+    args = parser.parse_args()
+
+    try:
+        crashes = find_crashes(args.log)
+    except CrashRecordError as e:
+        print(f"[CRASH] ERROR: {e}")
+        return 1
+    if not crashes:
+        print(f"[CRASH] No crash records in {args.log}")
+        return 1
+
+    symbols = load_symbols(args.elf, args.toolchain_prefix)
+    for crash in crashes:
+        if symbols:
+            crash.symbolize(symbols)
+        crash.print_report()
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump([crash.to_dict() for crash in crashes], f, indent=2)
+        print(f"[CRASH] Report saved to {args.json}")
+
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+
+"""Address-to-symbol lookup for firmware ELF files using binutils"""
+
+import bisect
+import subprocess
+from typing import Dict, List, Optional, Tuple
+
+class ElfSymbols:
+    def __init__(self, elf_path: str, toolchain_prefix: str = "arm-none-eabi-"):
+        self.elf_path = elf_path
+        self.toolchain_prefix = toolchain_prefix
+        self.addresses: List[int] = []
+        self.symbols: List[Tuple[int, int, str]] = []
+        self.cache: Dict[int, str] = {}
+        self.load()
+
+    def load(self):
+        """Read function symbols (address, size, name) sorted by address"""
+        cmd = [self.toolchain_prefix + "nm", "-n", "-S", "--defined-only", self.elf_path]
+        output = subprocess.run(cmd, capture_output=True, text=True, check=True).stdout
+
+        for line in output.splitlines():
+            fields = line.split()
+            if len(fields) == 4 and fields[2] in "TtWw":
+                address, size, _, name = fields
+                self.symbols.append((int(address, 16) & ~1, int(size, 16), name))
+            elif len(fields) == 3 and fields[1] in "TtWw":
+                address, _, name = fields
+                self.symbols.append((int(address, 16) & ~1, 0, name))
+
+        self.symbols.sort()
+        self.addresses = [s[0] for s in self.symbols]
+
+    def lookup(self, address: int) -> str:
+        """Function name containing the address, with offset when not at its start"""
+        address &= ~1  # Thumb bit
+        if address in self.cache:
+            return self.cache[address]
+
+        index = bisect.bisect_right(self.addresses, address) - 1
+        if index < 0:
+            name = f"0x{address:08x}"
+        else:
+            start, size, symbol = self.symbols[index]
+            if size and address >= start + size:
+                name = f"0x{address:08x}"
+            elif address == start:
+                name = symbol
+            else:
+                name = f"{symbol}+0x{address - start:x}"
+
+        self.cache[address] = name
+        return name
+
+    def function(self, address: int) -> str:
+        """Function name only, for aggregating samples by function"""
+        return self.lookup(address).split('+')[0]
+
+    def source_line(self, address: int) -> Optional[str]:
+        """file:line for an address via addr2line, or None if unknown"""
+        cmd = [self.toolchain_prefix + "addr2line", "-e", self.elf_path, f"0x{address & ~1:x}"]
+        try:
+            location = subprocess.run(cmd, capture_output=True, text=True, check=True).stdout.strip()
+        except (OSError, subprocess.CalledProcessError):
+            return None
+        return None if location.startswith("??") else location
+
+    def contains(self, address: int) -> bool:
+        """True if the address falls inside a sized function symbol"""
+        address &= ~1
+        index = bisect.bisect_right(self.addresses, address) - 1
+        if index < 0:
+            return False
+        start, size, _ = self.symbols[index]
+        return start <= address < start + size
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+
+"""Symbolize a function-trace capture (make FUNC_TRACE=1) into per-function
+cycle totals and a call tree. See include/test_func_trace.h for the format."""
+
+import argparse
+import json
+import struct
+import sys
+from dataclasses import dataclass, field
+from typing import Dict, List
+
+from elf_symbols import ElfSymbols
+
+LOSS_MARKER = 0xFFFFFFFF
+
+@dataclass
+class FunctionStats:
+    name: str
+    calls: int = 0
+    inclusive: int = 0
+    exclusive: int = 0
+
+@dataclass
+class CallNode:
+    name: str
+    calls: int = 0
+    inclusive: int = 0
+    children: Dict[str, 'CallNode'] = field(default_factory=dict)
+
+    def child(self, name: str) -> 'CallNode':
+        if name not in self.children:
+            self.children[name] = CallNode(name)
+        return self.children[name]
+
+    def to_dict(self) -> dict:
+        return {
+            'name': self.name,
+            'calls': self.calls,
+            'inclusive_cycles': self.inclusive,
+            'children': [c.to_dict() for c in sorted(self.children.values(), key=lambda c: -c.inclusive)]
+        }
+
+@dataclass
+class Frame:
+    address: int
+    enter_cycles: int
+    node: CallNode
+    child_cycles: int = 0
+
+class FunctionTraceAnalyzer:
+    def __init__(self, symbols: ElfSymbols):
+        self.symbols = symbols
+        self.functions: Dict[str, FunctionStats] = {}
+        self.root = CallNode("<root>")
+        self.stack: List[Frame] = []
+        self.records = 0
+        self.losses = 0
+        self.unmatched_exits = 0
+
+    def decode(self, data: bytes):
+        address = 0
+        cycles = 0
+        after_loss = False
+
+        for offset in range(0, len(data) - len(data) % 8, 8):
+            word0, word1 = struct.unpack_from('<II', data, offset)
+
+            if word0 == 0 and word1 == LOSS_MARKER:
+                # Records were dropped: open frames can no longer be trusted
+                self.losses += 1
+                self.stack.clear()
+                after_loss = True
+                continue
+
+            delta = word0 & ~1
+            if delta & 0x80000000:
+                delta -= 1 << 32
+            address = (delta if after_loss else address + delta) & 0xFFFFFFFF
+            cycles += word1
+            after_loss = False
+            self.records += 1
+
+            if word0 & 1:
+                self.exit(address, cycles)
+            else:
+                self.enter(address, cycles)
+
+    def enter(self, address: int, cycles: int):
+        name = self.symbols.function(address)
+        parent = self.stack[-1].node if self.stack else self.root
+        node = parent.child(name)
+        node.calls += 1
+        self.stack.append(Frame(address, cycles, node))
+
+    def exit(self, address: int, cycles: int):
+        # Unwind frames whose exit was never seen (e.g. longjmp)
+        while self.stack and self.stack[-1].address != address:
+            self.stack.pop()
+            self.unmatched_exits += 1
+        if not self.stack:
+            self.unmatched_exits += 1
+            return
+
+        frame = self.stack.pop()
+        inclusive = cycles - frame.enter_cycles
+        frame.node.inclusive += inclusive
+
+        name = frame.node.name
+        stats = self.functions.setdefault(name, FunctionStats(name))
+        stats.calls += 1
+        stats.exclusive += inclusive - frame.child_cycles
+        # Recursive calls would count twice in inclusive time
+        if not any(f.node.name == name for f in self.stack):
+            stats.inclusive += inclusive
+
+        if self.stack:
+            self.stack[-1].child_cycles += inclusive
+
+    def print_report(self, cpu_hz: int, top: int, depth: int):
+        print(f"[FUNC_TRACE] {self.records} records, {self.losses} loss markers, "
+              f"{self.unmatched_exits} unmatched frames")
+        print(f"{'Function':40} {'Calls':>8} {'Inclusive':>12} {'Exclusive':>12} {'Excl us':>10}")
+        ranked = sorted(self.functions.values(), key=lambda f: -f.exclusive)
+        for stats in ranked[:top]:
+            print(f"{stats.name[:40]:40} {stats.calls:>8} {stats.inclusive:>12} "
+                  f"{stats.exclusive:>12} {stats.exclusive * 1e6 / cpu_hz:>10.1f}")
+
+        print("\nCall tree (inclusive cycles):")
+        self.print_tree(self.root, 0, depth)
+
+    def print_tree(self, node: CallNode, level: int, depth: int):
+        for child in sorted(node.children.values(), key=lambda c: -c.inclusive):
+            print(f"{'  ' * level}{child.name} x{child.calls} {child.inclusive}")
+            if level + 1 < depth:
+                self.print_tree(child, level + 1, depth)
+
+    def to_dict(self) -> dict:
+        return {
+            'records': self.records,
+            'losses': self.losses,
+            'unmatched_frames': self.unmatched_exits,
+            'functions': {name: {'calls': s.calls, 'inclusive_cycles': s.inclusive,
+                                 'exclusive_cycles': s.exclusive}
+                          for name, s in self.functions.items()},
+            'call_tree': self.root.to_dict()
+        }
+
+def main():
+    parser = argparse.ArgumentParser(description="Analyze an RTT function-trace capture")
+    parser.add_argument("capture", help="Binary capture of RTT channel 2")
+    parser.add_argument("elf", help="Firmware ELF used for symbolization")
+    parser.add_argument("--cpu-hz", type=int, default=168000000)
+    parser.add_argument("--top", type=int, default=20, help="Functions to list (default: 20)")
+    parser.add_argument("--depth", type=int, default=6, help="Call tree depth to print (default: 6)")
+    parser.add_argument("--toolchain-prefix", default="arm-none-eabi-")
+    parser.add_argument("--json", help="Also write the report as JSON")
+    args = parser.parse_args()
+
+    with open(args.capture, 'rb') as f:
+        data = f.read()
+
+    analyzer = FunctionTraceAnalyzer(ElfSymbols(args.elf, args.toolchain_prefix))
+    analyzer.decode(data)
+    analyzer.print_report(args.cpu_hz, args.top, args.depth)
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(analyzer.to_dict(), f, indent=2)
+        print(f"[FUNC_TRACE] Report saved to {args.json}")
+
+    return 0 if analyzer.records else 1
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+
+"""Symbolize a PC-sampling profile capture (make PROFILE=1) into a flat
+profile and folded stacks for flamegraph.pl / speedscope. See
+include/test_profiler.h for the record format."""
+
+import argparse
+import json
+import struct
+import sys
+from collections import Counter
+from typing import Dict, Optional
+
+from elf_symbols import ElfSymbols
+
+EXTERNAL = 0xFFFFFFFF
+
+class ProfileAnalyzer:
+    def __init__(self, symbols: ElfSymbols):
+        self.symbols = symbols
+        self.samples: Counter = Counter()
+        self.total = 0
+
+    def decode(self, data: bytes):
+        for offset in range(0, len(data) - len(data) % 12, 12):
+            pc, lr, count = struct.unpack_from('<III', data, offset)
+            self.samples[(pc, lr)] += count
+            self.total += count
+
+    def name(self, address: int) -> str:
+        if address == EXTERNAL:
+            return "[external]"
+        return self.symbols.function(address)
+
+    def caller(self, pc_name: str, lr: int) -> Optional[str]:
+        """Function LR points into; only meaningful when the PC is in a leaf"""
+        # 0 means LR capture is off; 0xFxxxxxxx is an EXC_RETURN value
+        if lr == 0 or lr >= 0xF0000000:
+            return None
+        name = self.name(lr)
+        return None if name == pc_name else name
+
+    def flat(self) -> Dict[str, int]:
+        functions: Counter = Counter()
+        for (pc, _), count in self.samples.items():
+            functions[self.name(pc)] += count
+        return dict(functions)
+
+    def folded(self) -> Dict[str, int]:
+        stacks: Counter = Counter()
+        for (pc, lr), count in self.samples.items():
+            function = self.name(pc)
+            caller = self.caller(function, lr)
+            stacks[f"{caller};{function}" if caller else function] += count
+        return dict(stacks)
+
+    def hot_addresses(self, top: int) -> Dict[int, int]:
+        addresses: Counter = Counter()
+        for (pc, _), count in self.samples.items():
+            if pc != EXTERNAL:
+                addresses[pc] += count
+        return dict(addresses.most_common(top))
+
+    def print_report(self, rate_hz: int, top: int, lines: bool):
+        print(f"[PROFILE] {self.total} samples ({self.total / rate_hz:.2f} s at {rate_hz} Hz)")
+        print(f"{'Function':40} {'Samples':>8} {'%':>6}")
+        for name, count in sorted(self.flat().items(), key=lambda f: -f[1])[:top]:
+            print(f"{name[:40]:40} {count:>8} {100.0 * count / self.total:>6.1f}")
+
+        if lines:
+            print("\nHot addresses:")
+            for address, count in self.hot_addresses(top).items():
+                location = self.symbols.source_line(address) or "?"
+                print(f"  0x{address:08x} {count:>8} {self.symbols.lookup(address)} ({location})")
+
+    def write_folded(self, path: str):
+        with open(path, 'w') as f:
+            for stack, count in sorted(self.folded().items()):
+                f.write(f"{stack} {count}\n")
+
+    def to_dict(self) -> dict:
+        return {
+            'samples': self.total,
+            'functions': self.flat(),
+            'stacks': self.folded()
+        }
+
+def main():
+    parser = argparse.ArgumentParser(description="Analyze an RTT PC-sampling profile capture")
+    parser.add_argument("capture", help="Binary capture of RTT channel 3")
+    parser.add_argument("elf", help="Firmware ELF (or host executable) used for symbolization")
+    parser.add_argument("--rate-hz", type=int, default=1000,
+                        help="Sampling rate the firmware was built with (default: 1000)")
+    parser.add_argument("--top", type=int, default=20, help="Functions to list (default: 20)")
+    parser.add_argument("--lines", action="store_true", help="Also list hot addresses with file:line")
+    parser.add_argument("--folded", help="Write folded stacks for flamegraph.pl")
+    parser.add_argument("--toolchain-prefix", default="arm-none-eabi-",
+                        help="Binutils prefix; use '' for host builds")
+    parser.add_argument("--json", help="Also write the report as JSON")
+    args = parser.parse_args()
+
+    with open(args.capture, 'rb') as f:
+        data = f.read()
+
+    analyzer = ProfileAnalyzer(ElfSymbols(args.elf, args.toolchain_prefix))
+    analyzer.decode(data)
+    if not analyzer.total:
+        print("[PROFILE] No samples in capture")
+        return 1
+
+    analyzer.print_report(args.rate_hz, args.top, args.lines)
+
+    if args.folded:
+        analyzer.write_folded(args.folded)
+        print(f"[PROFILE] Folded stacks saved to {args.folded}")
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(analyzer.to_dict(), f, indent=2)
+        print(f"[PROFILE] Report saved to {args.json}")
+
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
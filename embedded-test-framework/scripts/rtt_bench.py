@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+
+"""Run the RTT throughput benchmark (make bench / make bench-host) and print
+a comparison table across buffer modes and sizes. See bench/rtt_bench.c for
+the BENCH line format. Also runs the formatter benchmark (make format-bench),
+whose FMTBENCH lines are described in bench/format_bench.c."""
+
+import argparse
+import json
+import os
+import re
+import sys
+from datetime import datetime
+from typing import List, Optional
+
+from rtt_monitor import ChannelCapture, RTTMonitor
+
+PREAMBLE = b'BNCH'
+
+class BenchMonitor(RTTMonitor):
+    def __init__(self, capture_path: str, **kwargs):
+        super().__init__(**kwargs)
+        self.capture = ChannelCapture(1, capture_path)
+        self.captures.append(self.capture)
+        self.runs: List[dict] = []
+        self.format_runs: List[dict] = []
+        self.expected_runs: Optional[int] = None
+        self.bench_pattern = re.compile(
+            r'BENCH:(\w+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):([01])')
+        self.format_pattern = re.compile(r'FMTBENCH:(\w+):(\d+):(\d+):(\d+):(\d+):([01])')
+        self.bench_done_pattern = re.compile(r'BENCHDONE:(\d+)')
+
+    def parse_rtt_line(self, line: str, host_time: Optional[float] = None):
+        bench_match = self.bench_pattern.search(line)
+        if bench_match:
+            mode = bench_match.group(1)
+            (size, record, attempted, accepted, short_writes, writer_cycles, max_write,
+             write_phase, elapsed, drained) = map(int, bench_match.groups()[1:])
+            self.runs.append(self.summarize(mode, size, record, attempted, accepted, short_writes,
+                                            writer_cycles, max_write, write_phase, elapsed, drained))
+            return None
+
+        format_match = self.format_pattern.search(line)
+        if format_match:
+            iterations, ours, libc, length, match = map(int, format_match.groups()[1:])
+            self.format_runs.append({
+                'pattern': format_match.group(1),
+                'iterations': iterations,
+                'length': length,
+                'test_format_cycles': ours / iterations if iterations else 0.0,
+                'snprintf_cycles': libc / iterations if iterations else 0.0,
+                'speedup': libc / ours if ours else None,
+                'match': bool(match)
+            })
+            return None
+
+        done_match = self.bench_done_pattern.search(line)
+        if done_match:
+            self.expected_runs = int(done_match.group(1))
+            return None
+
+        return super().parse_rtt_line(line, host_time)
+
+    def summarize(self, mode, size, record, attempted, accepted, short_writes,
+                  writer_cycles, max_write, write_phase, elapsed, drained) -> dict:
+        cpu_hz = self.clock.cpu_hz
+        offered = attempted * record
+        return {
+            'mode': mode,
+            'buffer_size': size,
+            'record_size': record,
+            'records': attempted,
+            'offered_bytes': offered,
+            'delivered_bytes': accepted,
+            'loss_pct': 100.0 * (offered - accepted) / offered if offered else 0.0,
+            'short_writes': short_writes,
+            'delivered_bytes_per_s': accepted * cpu_hz / elapsed if elapsed else 0.0,
+            'offered_bytes_per_s': offered * cpu_hz / write_phase if write_phase else 0.0,
+            'writer_cycles_per_record': writer_cycles / attempted if attempted else 0.0,
+            'writer_cycles_per_byte': writer_cycles / accepted if accepted else None,
+            'writer_cpu_pct': 100.0 * writer_cycles / write_phase if write_phase else 0.0,
+            'max_write_cycles': max_write,
+            'drained': bool(drained)
+        }
+
+    def check_success_condition(self) -> bool:
+        return (self.expected_runs is not None
+                and len(self.runs) + len(self.format_runs) >= self.expected_runs)
+
+    def verify_capture(self) -> Optional[bool]:
+        """Bytes captured on the bench channel must equal the bytes the target had accepted"""
+        if not self.runs or not os.path.exists(self.capture.path):
+            return None
+        captured = os.path.getsize(self.capture.path)
+        expected = len(PREAMBLE) + sum(r['delivered_bytes'] for r in self.runs)
+        if captured != expected:
+            print(f"[RTT_BENCH] WARNING: captured {captured} bytes, target accepted {expected}")
+            return False
+        return True
+
+    def print_table(self):
+        print(f"[RTT_BENCH] {len(self.runs)} runs, CPU {self.clock.cpu_hz} Hz")
+        print(f"  {'Mode':6} {'Size':>6} {'Records':>9} {'Loss %':>7} {'KB/s':>9} {'Offered KB/s':>13} "
+              f"{'Cyc/rec':>8} {'Writer %':>9} {'Max cyc':>9} {'Drained':>8}")
+        for r in self.runs:
+            print(f"  {r['mode']:6} {r['buffer_size']:>6} {r['records']:>9} {r['loss_pct']:>7.2f} "
+                  f"{r['delivered_bytes_per_s'] / 1024:>9.1f} {r['offered_bytes_per_s'] / 1024:>13.1f} "
+                  f"{r['writer_cycles_per_record']:>8.0f} {r['writer_cpu_pct']:>9.1f} "
+                  f"{r['max_write_cycles']:>9} {'yes' if r['drained'] else 'NO':>8}")
+
+    def print_format_table(self):
+        print("[RTT_BENCH] Formatter, cycles per call")
+        print(f"  {'Pattern':12} {'Length':>7} {'test_format':>12} {'snprintf':>10} {'Speedup':>8} {'Output':>7}")
+        for r in self.format_runs:
+            speedup = f"{r['speedup']:.2f}x" if r['speedup'] else "-"
+            print(f"  {r['pattern']:12} {r['length']:>7} {r['test_format_cycles']:>12.0f} "
+                  f"{r['snprintf_cycles']:>10.0f} {speedup:>8} {'same' if r['match'] else 'DIFF':>7}")
+
+def main():
+    parser = argparse.ArgumentParser(
+        usage="python3 rtt_bench.py <device> [interface] [speed] [timeout] [options]",
+        epilog="Example: python3 rtt_bench.py STM32F407VG SWD 4000 120")
+    parser.add_argument("device", nargs="?")
+    parser.add_argument("interface", nargs="?", default="SWD")
+    parser.add_argument("speed", nargs="?", type=int, default=4000)
+    parser.add_argument("timeout", nargs="?", type=int, default=120)
+    parser.add_argument("--host-exec", metavar="PATH", help="Run a host build (make bench-host)")
+    parser.add_argument("--capture", default="logs/bench_channel1.bin",
+                        help="Where to store the bench channel capture")
+    parser.add_argument("--json", help="Also write the results as JSON")
+    args = parser.parse_args()
+
+    if not args.device and not args.host_exec:
+        parser.error("device is required unless --host-exec is given")
+
+    os.makedirs(os.path.dirname(args.capture) or '.', exist_ok=True)
+    monitor = BenchMonitor(args.capture, device=args.device or "host", interface=args.interface,
+                           speed=args.speed, host_exec=args.host_exec)
+    monitor.monitor_until_success(timeout_seconds=args.timeout)
+
+    if not monitor.runs and not monitor.format_runs:
+        print("[RTT_BENCH] ERROR: no benchmark results received")
+        return 1
+
+    if monitor.runs:
+        monitor.print_table()
+    if monitor.format_runs:
+        monitor.print_format_table()
+    verified = monitor.verify_capture()
+    if any(not r['match'] for r in monitor.format_runs):
+        print("[RTT_BENCH] WARNING: test_format() and snprintf() output differ")
+        verified = False
+
+    output = args.json or f"logs/rtt_bench_{datetime.now().strftime('%Y%m%d_%H%M%S')}.json"
+    os.makedirs(os.path.dirname(output) or '.', exist_ok=True)
+    with open(output, 'w') as f:
+        json.dump({'cpu_hz': monitor.clock.cpu_hz, 'capture_verified': verified,
+                   'runs': monitor.runs, 'format_runs': monitor.format_runs}, f, indent=2)
+    print(f"[RTT_BENCH] Results saved to {output}")
+
+    complete = monitor.check_success_condition()
+    if not complete:
+        print("[RTT_BENCH] WARNING: benchmark did not finish before the timeout")
+    return 0 if complete and verified is not False else 1
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+
+"""Write the RTT manifest for a firmware ELF: the address of the _SEGGER_RTT
+control block and the channels the build configured, with their ring buffers.
+rtt_monitor.py --rtt-manifest attaches at that address instead of searching
+target RAM. config/rtt_cb.ld keeps the address fixed across builds."""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+from typing import Dict, List, Optional, Tuple
+
+CONTROL_BLOCK = "_SEGGER_RTT"
+
+# (channel, name, ring buffer symbols): SEGGER_RTT.c's own buffers, then the host shim's
+UP_CHANNELS = [
+    (0, "Terminal", ("_acUpBuffer", "terminal_up_buffer")),
+    (1, "Trace", ("trace_buffer",)),
+    (2, "FuncTrace", ("func_trace_buffer",)),
+    (3, "Profile", ("profile_buffer",)),
+    (4, "Coverage", ("coverage_buffer",)),
+    (5, "Bulk", ("bulk_buffer",)),
+    (6, "LogZ", ("logz_buffer",)),
+]
+DOWN_CHANNELS = [
+    (0, "Terminal", ("_acDownBuffer", "terminal_down_buffer")),
+    (1, "Credits", ("flow_down_buffer",)),
+]
+
+def read_symbols(elf: str, toolchain_prefix: str) -> Dict[str, Tuple[int, int]]:
+    """Data and code symbols with a size: name -> (address, size)"""
+    cmd = [toolchain_prefix + "nm", "-S", "--defined-only", elf]
+    output = subprocess.run(cmd, capture_output=True, text=True, check=True).stdout
+    symbols = {}
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) == 4:
+            address, size, _, name = fields
+            symbols.setdefault(name, (int(address, 16), int(size, 16)))
+    return symbols
+
+def channels(symbols: Dict[str, Tuple[int, int]], layout) -> List[dict]:
+    """Channels whose ring buffer is linked in; the others were compiled out"""
+    found = []
+    for channel, name, buffers in layout:
+        buffer = next((b for b in buffers if b in symbols), None)
+        if buffer:
+            address, size = symbols[buffer]
+            found.append({'channel': channel, 'name': name, 'buffer': buffer,
+                          'address': f"0x{address:08x}", 'size': size})
+    return found
+
+def build_manifest(elf: str, toolchain_prefix: str) -> Optional[dict]:
+    symbols = read_symbols(elf, toolchain_prefix)
+    if CONTROL_BLOCK not in symbols:
+        return None
+    address, size = symbols[CONTROL_BLOCK]
+    return {
+        'elf': elf,
+        'control_block': {
+            'symbol': CONTROL_BLOCK,
+            'address': f"0x{address:08x}",
+            'size': size,
+        },
+        'up': channels(symbols, UP_CHANNELS),
+        'down': channels(symbols, DOWN_CHANNELS),
+    }
+
+def load_manifest(path: str) -> dict:
+    """Manifest with the control block address as an int, for the host tools"""
+    with open(path) as f:
+        manifest = json.load(f)
+    manifest['control_block']['address'] = int(manifest['control_block']['address'], 16)
+    return manifest
+
+def main():
+    parser = argparse.ArgumentParser(description="Write the RTT control block manifest for an ELF")
+    parser.add_argument("elf", help="Firmware ELF (or host executable)")
+    parser.add_argument("-o", "--output", help="Manifest path (default: ELF with .rtt.json)")
+    parser.add_argument("--toolchain-prefix", default="arm-none-eabi-",
+                        help="Binutils prefix; use '' for host builds")
+    args = parser.parse_args()
+
+    try:
+        manifest = build_manifest(args.elf, args.toolchain_prefix)
+    except (OSError, subprocess.CalledProcessError) as e:
+        print(f"[RTT_MANIFEST] ERROR: cannot read symbols from {args.elf}: {e}")
+        return 1
+    if manifest is None:
+        print(f"[RTT_MANIFEST] ERROR: no {CONTROL_BLOCK} in {args.elf}")
+        return 1
+
+    output = args.output or os.path.splitext(args.elf)[0] + ".rtt.json"
+    with open(output, 'w') as f:
+        json.dump(manifest, f, indent=2)
+
+    block = manifest['control_block']
+    up = ', '.join(f"{c['channel']}:{c['name']}" for c in manifest['up'])
+    print(f"[RTT_MANIFEST] {block['symbol']} at {block['address']} ({block['size']} bytes), "
+          f"up channels {up}: {output}")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
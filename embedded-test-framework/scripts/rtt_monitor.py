@@ -1,15 +1,34 @@
 #!/usr/bin/env python3
 
+import os
 import subprocess
 import time
 import re
 import sys
 import json
+import math
+import threading
+import struct
+import argparse
+import sqlite3
+from collections import deque
 from datetime import datetime
-from typing import Dict, List, Optional
+from typing import Dict, List, Optional, Tuple
+from urllib.parse import unquote
 from dataclasses import dataclass
 from enum import Enum
 
+from crash_report import CRASH_PATTERN, CrashRecord, CrashRecordError, load_symbols
+from rtt_manifest import load_manifest
+
+# test_write_policy_t values (TEST_WRITE_* in test_rtt_logger.h)
+WRITE_POLICIES = {0: 'BLOCK', 1: 'TRIM', 2: 'DROP'}
+
+LOG_LEVELS = ['ERROR', 'WARN', 'INFO', 'DEBUG']
+
+# Up channel of the compressed log (RTT_CHANNEL_LOGZ in test_rtt_logger.h)
+RTT_CHANNEL_LOGZ = 6
+
 class TestStatus(Enum):
     INIT = "TEST_INIT"
     RUNNING = "TEST_RUNNING"
@@ -31,28 +50,1143 @@ class TestResult:
         if self.timestamp is None:
             self.timestamp = datetime.now().isoformat()
 
+@dataclass
+class SoakTestAggregate:
+    name: str
+    runs: int = 0
+    passed: int = 0
+    failed: int = 0
+    min_cycles: int = 0
+    max_cycles: int = 0
+    histogram: Dict[int, int] = None
+    
+    def percentile(self, pct: float) -> int:
+        """Upper bound of the log2 bucket containing the given percentile"""
+        total = sum(self.histogram.values())
+        if total == 0:
+            return 0
+        threshold = total * pct / 100
+        seen = 0
+        for bucket in sorted(self.histogram):
+            seen += self.histogram[bucket]
+            if seen >= threshold:
+                return min(2 ** (bucket + 1), self.max_cycles)
+        return self.max_cycles
+
+def hist_bucket_bounds(index: int, sub_bits: int):
+    """Value range [low, high) covered by a log-linear histogram bucket"""
+    sub_count = 1 << sub_bits
+    if index < sub_count:
+        return index, index + 1
+    shift = (index >> sub_bits) - 1
+    low = (sub_count + (index & (sub_count - 1))) << shift
+    return low, low + (1 << shift)
+
+def hist_bucket(value: int, sub_bits: int) -> int:
+    """Log-linear histogram bucket, identical to test_hist_bucket() on target"""
+    sub_count = 1 << sub_bits
+    if value < sub_count:
+        return value
+    shift = value.bit_length() - 1 - sub_bits
+    return ((shift + 1) << sub_bits) | ((value >> shift) & (sub_count - 1))
+
+def hist_percentile(buckets: Dict[int, int], sub_bits: int, pct: float) -> int:
+    """Percentile estimate (bucket midpoint) from a sparse log-linear histogram"""
+    total = sum(buckets.values())
+    if total == 0:
+        return 0
+    threshold = total * pct / 100
+    seen = 0
+    for index in sorted(buckets):
+        seen += buckets[index]
+        if seen >= threshold:
+            low, high = hist_bucket_bounds(index, sub_bits)
+            return (low + high - 1) // 2
+    return 0
+
+class ClockCorrelator:
+    """Maps target cycle counts to host wall-clock time.
+    
+    SYNC records pair a target cycle count with the host receive time. Receive
+    times include polling and pipe delay, which is always positive, so the fit
+    is the line below all sync points of a rolling window that minimizes the
+    total delay: the lower convex hull edge spanning the mean target time.
+    """
+    
+    def __init__(self, cpu_hz=168000000, window=256):
+        self.cpu_hz = cpu_hz
+        self.points = deque(maxlen=window)
+        self.wrap_base = 0
+        self.last_raw = None
+        self.slope = 1.0
+        self.offset = None
+        self.sync_count = 0
+        self.missed_syncs = 0
+        self.last_sequence = None
+    
+    def unwrap(self, cycles: int) -> int:
+        """Extend the 32-bit cycle counter. Only a drop of more than half the range is a
+        wrap; a smaller step either way is a record that arrived out of emit order"""
+        half = 1 << 31
+        if self.last_raw is not None:
+            if self.last_raw - cycles > half:
+                self.wrap_base += 1 << 32
+            elif cycles - self.last_raw > half and self.wrap_base:
+                # Stamped before the last wrap: it belongs to the previous period
+                return self.wrap_base - (1 << 32) + cycles
+            elif cycles < self.last_raw:
+                return self.wrap_base + cycles
+        self.last_raw = cycles
+        return self.wrap_base + cycles
+    
+    def add_sync(self, sequence: int, cycles: int, host_time: float):
+        if self.last_sequence is not None and sequence > self.last_sequence + 1:
+            self.missed_syncs += sequence - self.last_sequence - 1
+        self.last_sequence = sequence
+        self.sync_count += 1
+        
+        self.points.append((self.unwrap(cycles), host_time))
+        self.fit()
+    
+    def fit(self):
+        # Target times relative to the window start keep float precision
+        base = self.points[0][0]
+        pts = [((c - base) / self.cpu_hz, h) for c, h in self.points]
+        
+        hull = []
+        for p in pts:
+            while len(hull) >= 2 and \
+                    (hull[-1][0] - hull[-2][0]) * (p[1] - hull[-2][1]) - \
+                    (hull[-1][1] - hull[-2][1]) * (p[0] - hull[-2][0]) <= 0:
+                hull.pop()
+            hull.append(p)
+        
+        if len(hull) >= 2 and hull[-1][0] > hull[0][0]:
+            mean_t = sum(p[0] for p in pts) / len(pts)
+            for a, b in zip(hull, hull[1:]):
+                if b[0] >= mean_t:
+                    break
+            self.slope = (b[1] - a[1]) / (b[0] - a[0])
+            anchor = a
+        else:
+            anchor = min(pts, key=lambda p: p[1] - self.slope * p[0])
+        
+        self.offset = anchor[1] - self.slope * (anchor[0] + base / self.cpu_hz)
+    
+    def to_host_time(self, unwrapped_cycles: int) -> Optional[float]:
+        if self.offset is None:
+            return None
+        return self.offset + self.slope * (unwrapped_cycles / self.cpu_hz)
+    
+    def report(self) -> dict:
+        residuals = [h - self.to_host_time(c) for c, h in self.points] \
+            if self.offset is not None else []
+        return {
+            'cpu_hz_nominal': self.cpu_hz,
+            'cpu_hz_estimated': self.cpu_hz / self.slope,
+            'drift_ppm': (1.0 / self.slope - 1.0) * 1e6,
+            'offset': self.offset,
+            'sync_records': self.sync_count,
+            'missed_sync_records': self.missed_syncs,
+            'max_receive_delay_ms': max(residuals) * 1000 if residuals else None
+        }
+
+class LatencyTracker:
+    """Constant-memory latency distributions (microseconds) keyed by channel"""
+    
+    SUB_BITS = 3
+    
+    def __init__(self):
+        self.channels = {}
+    
+    def record(self, channel: str, latency_s: float):
+        us = max(int(latency_s * 1e6), 0)
+        stats = self.channels.setdefault(channel, {'count': 0, 'sum': 0, 'min': us, 'max': us, 'buckets': {}})
+        stats['count'] += 1
+        stats['sum'] += us
+        stats['min'] = min(stats['min'], us)
+        stats['max'] = max(stats['max'], us)
+        bucket = hist_bucket(us, self.SUB_BITS)
+        stats['buckets'][bucket] = stats['buckets'].get(bucket, 0) + 1
+    
+    def report(self) -> dict:
+        report = {}
+        for channel, stats in self.channels.items():
+            def pct(p):
+                return min(max(hist_percentile(stats['buckets'], self.SUB_BITS, p), stats['min']), stats['max'])
+            report[channel] = {
+                'count': stats['count'],
+                'mean_us': stats['sum'] / stats['count'],
+                'min_us': stats['min'],
+                'p50_us': pct(50),
+                'p90_us': pct(90),
+                'p99_us': pct(99),
+                'max_us': stats['max']
+            }
+        return report
+    
+    def print_report(self):
+        print("[RTT_MONITOR] Latency (us):")
+        for channel, r in self.report().items():
+            print(f"  {channel}: n={r['count']} min={r['min_us']} p50={r['p50_us']} "
+                  f"p90={r['p90_us']} p99={r['p99_us']} max={r['max_us']}")
+
+class OccupancyTracker:
+    """Terminal up-buffer fill per test (RTTOCC lines, make OCCUPANCY=1)"""
+    
+    BUCKETS = 16  # TEST_OCCUPANCY_BUCKETS; bucket 16 counts writes that did not fit
+    
+    def __init__(self, cpu_hz=168000000):
+        self.cpu_hz = cpu_hz
+        self.size = 0
+        self.tests = {}
+    
+    def add(self, name: str, size: int, writes: int, dropped: int, high_water: int,
+            near_full_cycles: int, hist: str):
+        self.size = size
+        stats = self.tests.setdefault(name, {'writes': 0, 'dropped': 0, 'high_water': 0,
+                                             'near_full_cycles': 0, 'buckets': {}})
+        stats['writes'] += writes
+        stats['dropped'] += dropped
+        stats['high_water'] = max(stats['high_water'], high_water)
+        stats['near_full_cycles'] += near_full_cycles
+        for pair in filter(None, hist.split(',')):
+            bucket, count = map(int, pair.split('='))
+            stats['buckets'][bucket] = stats['buckets'].get(bucket, 0) + count
+    
+    def bucket_limit(self, bucket: int) -> int:
+        """Largest fill in bytes that lands in a bucket"""
+        return (bucket + 1) * self.size // self.BUCKETS
+    
+    def percentile(self, stats: dict, pct: float) -> Optional[int]:
+        """Fill in bytes at a percentile, None if it lies among dropped writes"""
+        target = math.ceil(stats['writes'] * pct / 100.0)
+        seen = 0
+        for bucket in sorted(stats['buckets']):
+            seen += stats['buckets'][bucket]
+            if seen >= target:
+                if bucket >= self.BUCKETS:
+                    return None
+                return min(self.bucket_limit(bucket), stats['high_water'])
+        return stats['high_water']
+    
+    def total(self) -> dict:
+        total = {'writes': 0, 'dropped': 0, 'high_water': 0, 'near_full_cycles': 0, 'buckets': {}}
+        for stats in self.tests.values():
+            total['writes'] += stats['writes']
+            total['dropped'] += stats['dropped']
+            total['high_water'] = max(total['high_water'], stats['high_water'])
+            total['near_full_cycles'] += stats['near_full_cycles']
+            for bucket, count in stats['buckets'].items():
+                total['buckets'][bucket] = total['buckets'].get(bucket, 0) + count
+        return total
+    
+    def recommend(self, loss_target: float) -> dict:
+        """Smallest power-of-two buffer whose expected loss rate stays within loss_target"""
+        total = self.total()
+        if not total['writes']:
+            return {}
+        
+        allowed = int(total['writes'] * loss_target)
+        above = total['writes']
+        required = None
+        # Walk up until the writes above a fill level fit in the loss budget
+        for bucket in range(self.BUCKETS):
+            above -= total['buckets'].get(bucket, 0)
+            if above <= allowed:
+                required = min(self.bucket_limit(bucket), total['high_water'])
+                break
+        
+        if required is None:
+            # Demand beyond the current buffer is unknown: suggest doubling and rerunning
+            return {'loss_target': loss_target, 'required_bytes': None,
+                    'recommended_size': self.size * 2, 'current_size': self.size,
+                    'note': 'writes were dropped; rerun with the recommended size to refine'}
+        
+        recommended = 64
+        while recommended <= required:
+            recommended *= 2
+        return {'loss_target': loss_target, 'required_bytes': required,
+                'recommended_size': recommended, 'current_size': self.size}
+    
+    def report(self, loss_target: float) -> dict:
+        def summarize(stats):
+            return {
+                'writes': stats['writes'],
+                'dropped': stats['dropped'],
+                'p50_bytes': self.percentile(stats, 50),
+                'p90_bytes': self.percentile(stats, 90),
+                'p99_bytes': self.percentile(stats, 99),
+                'high_water_bytes': stats['high_water'],
+                'near_full_ms': stats['near_full_cycles'] * 1000.0 / self.cpu_hz
+            }
+        return {
+            'buffer_size': self.size,
+            'tests': {name: summarize(stats) for name, stats in self.tests.items()},
+            'total': summarize(self.total()),
+            'recommendation': self.recommend(loss_target)
+        }
+    
+    def print_report(self, loss_target: float):
+        report = self.report(loss_target)
+        print(f"[RTT_MONITOR] Up-buffer occupancy (channel 0, {report['buffer_size']} bytes):")
+        print(f"  {'Test':32} {'Writes':>7} {'Drop':>5} {'p50':>6} {'p90':>6} {'p99':>6} {'HWM':>6} {'NearFull ms':>12}")
+        rows = list(report['tests'].items()) + [('(all)', report['total'])]
+        for name, r in rows:
+            cells = [str(r[k]) if r[k] is not None else 'full' for k in ('p50_bytes', 'p90_bytes', 'p99_bytes')]
+            print(f"  {name[:32]:32} {r['writes']:>7} {r['dropped']:>5} {cells[0]:>6} {cells[1]:>6} "
+                  f"{cells[2]:>6} {r['high_water_bytes']:>6} {r['near_full_ms']:>12.2f}")
+        rec = report['recommendation']
+        if rec:
+            print(f"  Recommended RTT_UP_SIZE for loss <= {loss_target:g}: {rec['recommended_size']} bytes"
+                  + (f" (peak demand {rec['required_bytes']} bytes)" if rec['required_bytes'] is not None
+                     else f" ({rec['note']})"))
+
+class KVStore:
+    """TEST_LOG_KV records in SQLite: a kv_<event> table per event with an indexed
+    column per key, so fields can be queried instead of grepped. The database is
+    only created once the first record arrives."""
+    
+    COLUMN_TYPES = {'i': 'INTEGER', 'u': 'INTEGER', 'b': 'INTEGER', 'f': 'REAL', 's': 'TEXT'}
+    BASE_COLUMNS = ('id', 'target_cycles', 'host_time', 'level', 'test')
+    COMMIT_EVERY = 1000
+    
+    def __init__(self, path: str):
+        self.path = path
+        self.db = None
+        self.tables = {}
+        self.counts = {}
+        self.truncated = 0
+        self.pending = 0
+    
+    @staticmethod
+    def quote(name: str) -> str:
+        return '"' + name.replace('"', '""') + '"'
+    
+    @staticmethod
+    def decode(kind: str, text: str):
+        if kind in 'iub':
+            return int(text)
+        if kind == 'f':
+            return struct.unpack('>d', bytes.fromhex(text))[0]
+        return unquote(text)
+    
+    def open(self):
+        os.makedirs(os.path.dirname(self.path) or '.', exist_ok=True)
+        self.db = sqlite3.connect(self.path)
+        self.db.execute('CREATE TABLE IF NOT EXISTS events (event TEXT PRIMARY KEY, table_name TEXT, records INTEGER)')
+    
+    def table_for(self, event: str):
+        if event in self.tables:
+            return self.tables[event]
+        
+        row = self.db.execute('SELECT table_name FROM events WHERE event = ?', (event,)).fetchone()
+        if row:
+            table = row[0]
+        else:
+            base = 'kv_' + (re.sub(r'\W+', '_', event).strip('_') or 'event')
+            used = {r[0] for r in self.db.execute('SELECT table_name FROM events')}
+            table, suffix = base, 2
+            while table in used:
+                table, suffix = f"{base}_{suffix}", suffix + 1
+            self.db.execute('INSERT INTO events VALUES (?, ?, 0)', (event, table))
+        
+        q = self.quote(table)
+        self.db.execute(f'CREATE TABLE IF NOT EXISTS {q} (id INTEGER PRIMARY KEY, target_cycles INTEGER, '
+                        f'host_time REAL, level TEXT, test TEXT)')
+        self.db.execute(f'CREATE INDEX IF NOT EXISTS {self.quote(table + "_test")} ON {q} (test)')
+        columns = {r[1] for r in self.db.execute(f'PRAGMA table_info({q})')}
+        self.tables[event] = (table, columns)
+        return self.tables[event]
+    
+    def column_for(self, table: str, columns: set, key: str, kind: str) -> str:
+        column = key + '_' if key in self.BASE_COLUMNS else key
+        if column not in columns:
+            q = self.quote(table)
+            self.db.execute(f'ALTER TABLE {q} ADD COLUMN {self.quote(column)} {self.COLUMN_TYPES.get(kind, "")}')
+            self.db.execute(f'CREATE INDEX IF NOT EXISTS {self.quote(table + "_" + column)} '
+                            f'ON {q} ({self.quote(column)})')
+            columns.add(column)
+        return column
+    
+    def insert(self, event: str, cycles: int, host_time: float, level: str,
+               test: Optional[str], fields: List[tuple]):
+        if self.db is None:
+            self.open()
+        
+        table, columns = self.table_for(event)
+        names = ['target_cycles', 'host_time', 'level', 'test']
+        values = [cycles, host_time, level, test]
+        for key, kind, value in fields:
+            column = self.column_for(table, columns, key, kind)
+            if column not in names:
+                names.append(column)
+                values.append(value)
+        
+        self.db.execute(f'INSERT INTO {self.quote(table)} ({", ".join(map(self.quote, names))}) '
+                        f'VALUES ({", ".join("?" * len(values))})', values)
+        self.counts[event] = self.counts.get(event, 0) + 1
+        self.pending += 1
+        if self.pending >= self.COMMIT_EVERY:
+            self.commit()
+    
+    def commit(self):
+        if self.db is None:
+            return
+        for event, count in self.counts.items():
+            self.db.execute('UPDATE events SET records = (SELECT COUNT(*) FROM '
+                            f'{self.quote(self.tables[event][0])}) WHERE event = ?', (event,))
+        self.db.commit()
+        self.pending = 0
+    
+    def close(self):
+        if self.db is not None:
+            self.commit()
+            self.db.close()
+            self.db = None
+    
+    def report(self) -> dict:
+        return {'database': self.path,
+                'records': sum(self.counts.values()),
+                'truncated': self.truncated,
+                'events': {event: {'table': self.tables[event][0], 'records': count}
+                           for event, count in self.counts.items()}}
+
+class ChannelCapture:
+    """Captures one binary RTT up channel to a file with JLinkRTTLogger"""
+    
+    def __init__(self, channel: int, path: str):
+        self.channel = channel
+        self.path = path
+        self.process = None
+    
+    def start(self, device, interface, speed, rtt_address: Optional[int] = None) -> bool:
+        cmd = [
+            "JLinkRTTLogger",
+            "-Device", device,
+            "-If", interface,
+            "-Speed", str(speed),
+            "-RTTChannel", str(self.channel)
+        ]
+        if rtt_address is not None:
+            cmd += ["-RTTAddress", f"0x{rtt_address:08x}"]
+        cmd.append(self.path)
+        try:
+            self.process = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            print(f"[RTT_MONITOR] Capturing RTT channel {self.channel} to {self.path}")
+            return True
+        except FileNotFoundError:
+            print("[RTT_MONITOR] ERROR: JLinkRTTLogger not found, channel capture disabled")
+            return False
+    
+    def stop(self):
+        if self.process:
+            self.process.terminate()
+            try:
+                self.process.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                self.process.kill()
+            self.process = None
+
+def open_jlink(device, interface, speed, rtt_address: Optional[int], purpose: str):
+    """pylink session with RTT started, at the control block address when it is known"""
+    try:
+        import pylink
+    except ImportError:
+        print(f"[RTT_MONITOR] ERROR: {purpose} on a probe needs pylink (pip install pylink-square)")
+        return None
+    
+    try:
+        jlink = pylink.JLink()
+        jlink.open()
+        jlink.set_tif(pylink.enums.JLinkInterfaces.SWD if interface == "SWD"
+                      else pylink.enums.JLinkInterfaces.JTAG)
+        jlink.set_speed(speed)
+        jlink.connect(device)
+        jlink.rtt_start(rtt_address)
+    except Exception as e:
+        print(f"[RTT_MONITOR] ERROR: pylink connection for {purpose} failed: {e}")
+        return None
+    return jlink
+
+class DirectTerminal:
+    """Channel 0 read through pylink in place of JLinkRTTClient (--rtt-manifest).
+
+    The probe attaches at the control block address from the manifest rather
+    than searching RAM for it. A thread copies the channel into a pipe, so the
+    monitor reads and polls this like the JLinkRTTClient process.
+    """
+    
+    def __init__(self, jlink, interval=0.005):
+        self.jlink = jlink
+        self.interval = interval
+        read_fd, self.write_fd = os.pipe()
+        self.stdout = os.fdopen(read_fd, 'r', errors='replace')
+        self.stopping = threading.Event()
+        self.thread = threading.Thread(target=self.run, daemon=True)
+        self.thread.start()
+    
+    def run(self):
+        try:
+            while not self.stopping.is_set():
+                data = self.jlink.rtt_read(0, 4096)
+                if data:
+                    os.write(self.write_fd, bytes(data))
+                else:
+                    self.stopping.wait(self.interval)
+        except Exception as e:
+            print(f"[RTT_MONITOR] ERROR: reading RTT channel 0 failed: {e}")
+        finally:
+            os.close(self.write_fd)
+    
+    def poll(self) -> Optional[int]:
+        return None if self.thread.is_alive() else 0
+    
+    def terminate(self):
+        self.stopping.set()
+    
+    def wait(self, timeout=None):
+        self.thread.join(timeout)
+    
+    def kill(self):
+        pass
+
+class SharedMemoryTerminal:
+    """RTT rings of a host build read from shared memory (--host-transport shm).
+
+    The shim maps its control block and rings into the POSIX segment named by
+    RTT_SHM_NAME (see host/SEGGER_RTT.h). A thread plays the probe: it drains
+    every up ring straight from the mapping, channel 0 into a pipe read like
+    the JLinkRTTClient process and captured channels into their files, and
+    writes down rings for the credit granter. Up channels nobody captures are
+    drained and dropped, as the shim does in pipe mode.
+    """
+
+    ID = b"SEGGER RTT"
+    HEADER = struct.Struct('<16sii')
+    BUFFER = struct.Struct('<QQIIII')       # sName, pBuffer, SizeOfBuffer, WrOff, RdOff, Flags
+    TRAILER = struct.Struct('<QII')         # rtt_shm_trailer_t
+
+    def __init__(self, process, name: str, captures, interval=0.002):
+        self.process = process
+        self.name = name
+        self.captures = {capture.channel: capture for capture in captures}
+        self.interval = interval
+        self.shm = None
+        self.files = {}
+        self.base = 0
+        self.up = 0
+        self.down = 0
+        self.bytes_read = 0
+        self.attached = threading.Event()
+        self.stopping = threading.Event()
+        read_fd, self.write_fd = os.pipe()
+        self.stdout = os.fdopen(read_fd, 'r', errors='replace')
+        self.thread = threading.Thread(target=self.run, daemon=True)
+        self.thread.start()
+
+    def attach(self) -> bool:
+        """Wait for the shim to map the segment and finish the control block"""
+        from multiprocessing import shared_memory
+        while not self.stopping.is_set():
+            # A build that has already exited may still have left a complete segment
+            exited = self.process.poll() is not None
+            try:
+                if self.shm is None:
+                    self.shm = shared_memory.SharedMemory(self.name)
+                acid, self.up, self.down = self.HEADER.unpack_from(self.shm.buf)
+                if acid.startswith(self.ID):
+                    trailer = self.HEADER.size + self.BUFFER.size * (self.up + self.down)
+                    self.base, _, _ = self.TRAILER.unpack_from(self.shm.buf, trailer)
+                    for channel, capture in self.captures.items():
+                        self.files[channel] = open(capture.path, 'wb')
+                    self.attached.set()
+                    return True
+            except (FileNotFoundError, ValueError):
+                pass        # not created, or not sized yet
+            if exited:
+                break
+            self.stopping.wait(self.interval)
+        return False
+
+    def descriptor(self, index: int) -> int:
+        return self.HEADER.size + self.BUFFER.size * index
+
+    def ring(self, offset: int):
+        """(buffer offset in the segment, size, WrOff, RdOff), or None for an unconfigured channel"""
+        _, buffer, size, wr, rd, _ = self.BUFFER.unpack_from(self.shm.buf, offset)
+        start = buffer - self.base
+        if size == 0 or buffer == 0 or start < 0 or start + size > self.shm.size:
+            return None
+        return start, size, wr, rd
+
+    def drain(self) -> int:
+        """Move everything in the up rings to its sink; returns the bytes moved"""
+        moved = 0
+        buf = self.shm.buf
+        for channel in range(self.up):
+            offset = self.descriptor(channel)
+            ring = self.ring(offset)
+            if ring is None or ring[2] == ring[3]:
+                continue
+            start, size, wr, rd = ring
+            spans = [(rd, wr)] if wr > rd else [(rd, size), (0, wr)]
+            for begin, end in spans:
+                if channel == 0:
+                    os.write(self.write_fd, buf[start + begin:start + end])
+                elif channel in self.files:
+                    self.files[channel].write(buf[start + begin:start + end])
+                moved += end - begin
+            struct.pack_into('<I', buf, offset + 24, wr)     # RdOff: hand the space back
+            if channel in self.files:
+                self.files[channel].flush()     # the credit granter reads the file size
+        self.bytes_read += moved
+        return moved
+
+    def write_down(self, channel: int, data: bytes):
+        """Store data in a down ring, waiting for the target to make room"""
+        while not self.attached.wait(self.interval):
+            if self.process.poll() is not None or self.stopping.is_set():
+                raise OSError("host build exited before mapping its RTT segment")
+        offset = self.descriptor(self.up + channel)
+        while data:
+            ring = self.ring(offset)
+            if ring is None:
+                return      # the build has no such channel; the pipe transport drops it too
+            start, size, wr, rd = ring
+            room = (rd - wr - 1) % size
+            chunk = min(room, len(data), size - wr)
+            if chunk == 0:
+                if self.process.poll() is not None or self.stopping.is_set():
+                    raise OSError("host build exited with its down ring full")
+                self.stopping.wait(self.interval)
+                continue
+            self.shm.buf[start + wr:start + wr + chunk] = data[:chunk]
+            struct.pack_into('<I', self.shm.buf, offset + 20, (wr + chunk) % size)
+            data = data[chunk:]
+
+    def run(self):
+        try:
+            if not self.attach():
+                return
+            while True:
+                # Checked before the drain, so what the process wrote last is still read
+                exited = self.process.poll() is not None
+                moved = self.drain()
+                if (exited or self.stopping.is_set()) and not moved:
+                    return
+                if not moved:
+                    self.stopping.wait(self.interval)
+        except Exception as e:
+            print(f"[RTT_MONITOR] ERROR: reading RTT shared memory failed: {e}")
+        finally:
+            os.close(self.write_fd)
+            for f in self.files.values():
+                f.close()
+
+    def poll(self) -> Optional[int]:
+        return None if self.thread.is_alive() else self.process.poll()
+
+    def terminate(self):
+        self.process.terminate()
+        self.stopping.set()
+
+    def wait(self, timeout=None):
+        self.process.wait(timeout)
+        self.thread.join(timeout)
+        self.close()
+
+    def kill(self):
+        self.process.kill()
+        self.thread.join(1)
+        self.close()
+
+    def close(self):
+        """Unmap and remove the segment once the reader is done with it"""
+        from multiprocessing import shared_memory
+        if self.thread.is_alive():
+            return
+        try:
+            # The build may have exited after creating it but before it was attached
+            shm = self.shm or shared_memory.SharedMemory(self.name)
+            shm.close()
+            shm.unlink()
+        except (BufferError, FileNotFoundError, ValueError):
+            pass
+        self.shm = None
+
+class CreditGranter:
+    """Grants flow-control credit (make FLOW=1) on down channel 1 as captures grow.
+
+    The grant for a channel is the number of bytes of it written to its capture
+    file, so the target never has more in flight than the host has taken in.
+    Host builds get grants through a pipe; on a probe they are written with
+    pylink, which must be installed. The monitor owns that pylink session.
+    """
+    
+    DOWN_CHANNEL = 1
+    GRANT = struct.Struct('<BI')
+    
+    def __init__(self, captures, interval=0.01):
+        self.captures = captures
+        self.interval = interval
+        self.granted = {}
+        self.grants_sent = 0
+        self.send = None
+        self.pipe_fd = None
+        self.thread = None
+        self.stopping = threading.Event()
+    
+    def open_pipe(self) -> int:
+        """Read end for a host build (RTT_DOWN_CHANNEL_1_FD)"""
+        read_fd, self.pipe_fd = os.pipe()
+        self.send = lambda data: os.write(self.pipe_fd, data)
+        return read_fd
+    
+    def connect(self, jlink):
+        self.send = lambda data: jlink.rtt_write(self.DOWN_CHANNEL, list(data))
+    
+    def grant_once(self):
+        for capture in self.captures:
+            try:
+                consumed = os.path.getsize(capture.path)
+            except OSError:
+                continue
+            if self.granted.get(capture.channel) == consumed:
+                continue
+            self.send(self.GRANT.pack(capture.channel, consumed & 0xFFFFFFFF))
+            self.granted[capture.channel] = consumed
+            self.grants_sent += 1
+    
+    def run(self):
+        while not self.stopping.is_set():
+            try:
+                self.grant_once()
+            except OSError:
+                return      # the target went away
+            self.stopping.wait(self.interval)
+    
+    def start(self):
+        if self.send is None:
+            return
+        self.thread = threading.Thread(target=self.run, daemon=True)
+        self.thread.start()
+        print(f"[RTT_MONITOR] Granting flow-control credit for channels "
+              f"{', '.join(str(c.channel) for c in self.captures)}")
+    
+    def stop(self):
+        self.stopping.set()
+        if self.thread:
+            self.thread.join(timeout=1)
+        if self.pipe_fd is not None:
+            os.close(self.pipe_fd)
+            self.pipe_fd = None
+
+class TraceDecoder:
+    """Decodes TRACE_* records from the RTT trace channel (see test_trace.h)"""
+    
+    DEFINE, BEGIN, END, INSTANT, COUNTER = range(5)
+    PHASES = {BEGIN: 'B', END: 'E', INSTANT: 'i', COUNTER: 'C'}
+    
+    def __init__(self):
+        self.names = {}
+        self.pending = b''
+        self.wrap_base = 0
+        self.last_raw = None
+        self.events = []
+    
+    def feed(self, data: bytes):
+        data = self.pending + data
+        pos = 0
+        while pos < len(data):
+            kind = data[pos]
+            if kind == self.DEFINE:
+                if pos + 3 > len(data) or pos + 3 + data[pos + 2] > len(data):
+                    break
+                length = data[pos + 2]
+                self.names[data[pos + 1]] = data[pos + 3:pos + 3 + length].decode('utf-8', 'replace')
+                pos += 3 + length
+            elif kind in self.PHASES:
+                size = 10 if kind == self.COUNTER else 6
+                if pos + size > len(data):
+                    break
+                record_id = data[pos + 1]
+                cycles, = struct.unpack_from('<I', data, pos + 2)
+                value = struct.unpack_from('<i', data, pos + 6)[0] if kind == self.COUNTER else None
+                self.events.append({
+                    'phase': self.PHASES[kind],
+                    'name': self.names.get(record_id, f"id_{record_id}"),
+                    'cycles': self.unwrap(cycles),
+                    'value': value
+                })
+                pos += size
+            else:
+                # Corrupt stream: resynchronize on the next plausible record type
+                pos += 1
+        self.pending = data[pos:]
+    
+    def unwrap(self, cycles: int) -> int:
+        if self.last_raw is not None and cycles < self.last_raw:
+            self.wrap_base += 1 << 32
+        self.last_raw = cycles
+        return self.wrap_base + cycles
+    
+    def export_chrome_trace(self, path: str, to_us):
+        """Write Chrome trace event JSON (loadable in Perfetto and chrome://tracing)"""
+        trace_events = []
+        for event in self.events:
+            record = {
+                'name': event['name'],
+                'ph': event['phase'],
+                'ts': to_us(event['cycles']),
+                'pid': 1,
+                'tid': 1
+            }
+            if event['phase'] == 'i':
+                record['s'] = 't'
+            elif event['phase'] == 'C':
+                record['args'] = {event['name']: event['value']}
+            trace_events.append(record)
+        
+        with open(path, 'w') as f:
+            json.dump({'traceEvents': trace_events, 'displayTimeUnit': 'ns'}, f)
+        
+        print(f"[RTT_MONITOR] Trace with {len(trace_events)} events saved to {path}")
+
+class CompressedLogDecoder:
+    """Turns the compressed log channel (make COMPRESS=1, see test_logz.h) back into text lines"""
+    
+    DEFINE, START, COST = 0x10, 0x20, 0x04
+    SPEC = re.compile(r'%([-0+ ]*)(\*|\d+)?(?:\.(\*|\d*))?(?:hh|h|ll|l|z|j|t)*(.)')
+    
+    def __init__(self):
+        self.formats = {}
+        self.pending = b''
+        self.cycles = 0             # sum of the deltas, so it never wraps
+        self.lines = 0
+        self.definitions = 0
+        self.errors = 0
+        self.record_bytes = 0       # everything read from the channel, definitions included
+        self.definition_bytes = 0
+        self.text_bytes = 0         # the same lines as text on channel 0, "\r\n" included
+    
+    @staticmethod
+    def varint(data: bytes, pos: int):
+        value = 0
+        shift = 0
+        while True:
+            byte = data[pos]        # IndexError: record not complete yet
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                return value, pos
+    
+    @staticmethod
+    def signed(data: bytes, pos: int):
+        value, pos = CompressedLogDecoder.varint(data, pos)
+        return (value >> 1) ^ -(value & 1), pos
+    
+    def expand(self, fmt: str, data: bytes, pos: int):
+        """test_format() over the encoded arguments; returns the text and the end of the record"""
+        out = []
+        last = 0
+        for match in self.SPEC.finditer(fmt):
+            out.append(fmt[last:match.start()])
+            last = match.end()
+            flags, width, precision, conversion = match.groups()
+            
+            if width == '*':
+                value, pos = self.signed(data, pos)
+                if value < 0:
+                    flags += '-'
+                width = str(abs(value))
+            if precision == '*':
+                value, pos = self.signed(data, pos)
+                precision = str(value) if value >= 0 else None
+            
+            if conversion == '%':
+                out.append('%')
+                continue
+            if conversion in 'fFeEgGaA':
+                out.append('?')
+                continue
+            if conversion not in 'diucxXops':
+                out.append('%' + conversion)
+                continue
+            
+            if conversion in 'dic':
+                value, pos = self.signed(data, pos)
+            elif conversion == 's':
+                length, pos = self.varint(data, pos)
+                if pos + length > len(data):
+                    raise IndexError
+                value = data[pos:pos + length].decode('utf-8', errors='replace')
+                pos += length
+            else:
+                value, pos = self.varint(data, pos)
+                flags = flags.replace('+', '').replace(' ', '')
+            
+            # C prints no digits for zero at precision 0, where Python prints "0"
+            if value == 0 and precision in ('0', '') and conversion in 'diuxXo':
+                sign = '+' if '+' in flags else ' ' if ' ' in flags else ''
+                out.append(('%' + ('-' if '-' in flags else '') + (width or '') + 's') % sign)
+                continue
+            
+            spec ='%' + flags + (width or '') + ('.' + precision if precision is not None else '')
+            if conversion == 'c':
+                out.append((spec + 'c') % chr(value & 0xFF))
+            elif conversion == 'p':
+                out.append((spec.replace('%', '%#', 1) + 'x') % value)
+            else:
+                out.append((spec + {'u': 'd', 'i': 'd'}.get(conversion, conversion)) % value)
+        out.append(fmt[last:])
+        return ''.join(out), pos
+    
+    def feed(self, data: bytes) -> List[Tuple[int, str]]:
+        """Complete records in data as (cycles, text line) pairs; a partial record waits for more"""
+        data = self.pending + data
+        lines = []
+        pos = 0
+        while pos < len(data):
+            start = pos
+            header = data[pos]
+            pos += 1
+            try:
+                if header == self.START:
+                    self.cycles = 0
+                elif header == self.DEFINE:
+                    slot, pos = self.varint(data, pos)
+                    length, pos = self.varint(data, pos)
+                    if pos + length > len(data):
+                        raise IndexError
+                    self.formats[slot] = data[pos:pos + length].decode('utf-8', errors='replace')
+                    self.definitions += 1
+                    pos += length
+                    self.definition_bytes += pos - start
+                elif header & ~(0x03 | self.COST) == 0:
+                    delta, pos = self.varint(data, pos)
+                    cost = None
+                    if header & self.COST:
+                        cost, pos = self.varint(data, pos)
+                    slot, pos = self.varint(data, pos)
+                    if slot not in self.formats:
+                        raise ValueError(f"format slot {slot} used before its definition")
+                    message, pos = self.expand(self.formats[slot], data, pos)
+                    
+                    self.cycles += delta
+                    timestamp = self.cycles & 0xFFFFFFFF
+                    stamp = f"[{timestamp:08d}+{cost}]" if cost is not None else f"[{timestamp:08d}]"
+                    line = f"{stamp} [{LOG_LEVELS[header & 0x03]}] {message}"
+                    lines.append((self.cycles, line))
+                    self.lines += 1
+                    self.text_bytes += len(line.encode('utf-8')) + 2
+                else:
+                    raise ValueError(f"unknown record type 0x{header:02x}")
+            except IndexError:
+                pos = start
+                break
+            except ValueError as e:
+                # Records are not self-delimiting; skip a byte and hope to land on the next one
+                if self.errors == 0:
+                    print(f"[RTT_MONITOR] WARNING: compressed log: {e}")
+                self.errors += 1
+                pos = start + 1
+            self.record_bytes += pos - start
+        self.pending = data[pos:]
+        return lines
+    
+    def report(self) -> dict:
+        return {
+            'lines': self.lines,
+            'bytes': self.record_bytes,
+            'text_bytes': self.text_bytes,
+            'bytes_per_line': self.record_bytes / self.lines if self.lines else 0.0,
+            'text_bytes_per_line': self.text_bytes / self.lines if self.lines else 0.0,
+            'definition_bytes': self.definition_bytes,
+            # Once every format has been sent
+            'line_bytes_per_line': ((self.record_bytes - self.definition_bytes) / self.lines
+                                    if self.lines else 0.0),
+            'formats': self.definitions,
+            'errors': self.errors
+        }
+
+@dataclass
+class TestRun:
+    passed: bool
+    duration_ms: int
+    duration_cycles: Optional[int] = None
+    blocked_cycles: int = 0         # waiting in blocking writes, not in duration_cycles
+
 class RTTMonitor:
-    def __init__(self, device="", interface="SWD", speed=4000):
+    def __init__(self, device="", interface="SWD", speed=4000, repeat=1, cv_threshold=0.1,
+                 soak=False, soak_log_lines=1000, host_exec=None, kv_path="logs/kv.db",
+                 host_transport="pipe"):
         self.device = device
+        self.host_exec = host_exec
+        self.host_transport = host_transport
         self.interface = interface
         self.speed = speed
         self.process = None
         self.test_results = {}
-        self.log_buffer = []
+        self.test_runs = {}
+        self.soak = soak
+        # Soak runs keep only the most recent lines; aggregates come from snapshots
+        self.log_buffer = deque(maxlen=soak_log_lines) if soak else []
+        self.soak_snapshot = None
+        self.soak_previous = None
+        self.soak_tests = {}
+        self.soak_snapshots_seen = 0
+        self.metrics = {}
+        self.metrics_scope = None
+        self.clock = ClockCorrelator()
+        self.latency = LatencyTracker()
+        self.occupancy = OccupancyTracker()
+        self.loss_target = 0.0
+        self.write_stats = {}
+        self.flow = None
+        self.flow_stats = {}
+        self.log_limits = {}
+        self.log_suppressed = None
+        self.log_samples = {}
+        self.log_defer = None
+        self.format_checks = {'lines': 0, 'mismatches': []}
+        self.postmortem = None
+        self.rtt_manifest = None
+        self.jlink = None
+        self.crash = None
+        self.elf = None
+        self.toolchain_prefix = "arm-none-eabi-"
+        self.captures = []
+        self.logz = None
+        self.logz_path = None
+        self.logz_file = None
+        self.logz_target = None
+        self.kv = KVStore(kv_path)
+        self.current_test = None
+        self.repeat = repeat
+        self.target_repeat = None
+        self.cv_threshold = cv_threshold
         
         # RTT log parsing patterns
         self.status_pattern = re.compile(r'STATUS:(\w+):(.+)')
-        self.result_pattern = re.compile(r'RESULT:(.+):(PASS|FAIL):(\d+)')
+        self.result_pattern = re.compile(r'RESULT:(.+):(PASS|FAIL):(\d+)(?::(\d+))?(?::(\d+))?')
+        self.config_pattern = re.compile(r'CONFIG:(\w+):(\d+)')
+        self.sync_pattern = re.compile(r'SYNC:(\d+):(\d+)')
+        self.trace_stat_pattern = re.compile(r'TRACESTAT:(\d+):(\d+):(\d+)')
+        self.func_trace_pattern = re.compile(r'FUNCTRACE:(\d+):(\d+)')
+        self.profile_pattern = re.compile(r'PROFILE:(\d+):(\d+):(\d+)')
+        self.occupancy_pattern = re.compile(r'RTTOCC:(.+):(\d+):(\d+):(\d+):(\d+):(\d+):([\d=,]*)')
+        self.write_stats_pattern = re.compile(r'WRITESTATS:(\w+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+)')
+        self.flow_pattern = re.compile(r'FLOW:(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+)')
+        self.bulk_pattern = re.compile(r'BULK:(\d+):(\d+):(\d+):(\d+)(?::(\d+))?')
+        self.coverage_pattern = re.compile(r'COVERAGE:(\d+):(\d+):(\d+)')
+        self.soak_pattern = re.compile(r'SOAK:(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+):(\d+)')
+        self.metrics_pattern = re.compile(r'METRICS:(.+):(\d+):(\d+)$')
+        self.metric_pattern = re.compile(r'METRIC:([CGH]):([^:]+):(.*)')
+        self.soak_test_pattern = re.compile(r'SOAKTEST:(.+):(\d+):(\d+):(\d+):(\d+):(\d+):([\d=,]*)')
         self.summary_pattern = re.compile(r'SUMMARY:(\d+):(\d+):(\d+)')
-        self.log_pattern = re.compile(r'\[(\d+)\] \[(\w+)\] (.+)')
+        self.log_pattern = re.compile(r'\[(\d+)(?:\+(\d+))?\] \[(\w+)\] (.+)')
+        self.log_limit_pattern = re.compile(r'LOGLIMIT:(.+):(\d+):(\d+)')
+        self.log_suppress_pattern = re.compile(r'LOGSUPPRESS:(\d+):(\d+)')
+        self.postmortem_pattern = re.compile(r'POSTMORTEM:(BEGIN|END|CLEAN|COLD|CORRUPT)((?::\d+)*)')
+        self.logz_pattern = re.compile(r'LOGZ:(\d+):(\d+):(\d+):(\d+)')
+        self.log_defer_pattern = re.compile(r'LOGDEFER:(\d+):(\d+):(\d+):(\d+)')
+        self.log_sample_pattern = re.compile(r'LOGSAMPLE:(.+):(\d+):(\d+):(\d+):(\d+)')
+        self.sample_tag_pattern = re.compile(r'^\[1/(\d+) ([^\]]+)\] ')
+        self.format_check_pattern = re.compile(r'^FMTCHECK:(\d+):(.*)$')
+        self.kv_pattern = re.compile(r'KV:(\d+):(\d+):(\S+)(.*)$')
         
         self.success_conditions = [
             TestStatus.COMPLETE,
             lambda results: all(r.status == TestStatus.PASS for r in results.values())
         ]
+        
+        # A single PASS must not end a repeated session early
+        if self.repeat > 1:
+            self.success_conditions = [TestStatus.COMPLETE]
+        
+        # Soak runs end on timeout only
+        if self.soak:
+            self.success_conditions = []
+        
+        # A host build runs to completion; read everything until it exits
+        if self.host_exec:
+            self.success_conditions = []
+    
+    def start_host_process(self):
+        """Run a host build (make host); binary channels go to the capture files"""
+        if self.host_transport == "shm":
+            return self.start_shared_memory_host()
+        
+        env = dict(os.environ)
+        for capture in self.captures:
+            env[f"RTT_CHANNEL_{capture.channel}_FILE"] = capture.path
+        
+        pass_fds = ()
+        if self.flow:
+            read_fd = self.flow.open_pipe()
+            env[f"RTT_DOWN_CHANNEL_{CreditGranter.DOWN_CHANNEL}_FD"] = str(read_fd)
+            pass_fds = (read_fd,)
+        
+        try:
+            self.process = subprocess.Popen(
+                [self.host_exec],
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+                bufsize=1,
+                env=env,
+                pass_fds=pass_fds
+            )
+            for fd in pass_fds:
+                os.close(fd)
+            print(f"[RTT_MONITOR] Started host build: {self.host_exec}")
+            return True
+        except OSError as e:
+            print(f"[RTT_MONITOR] ERROR: Failed to start host build: {e}")
+            return False
+    
+    def start_shared_memory_host(self):
+        """Run a host build with its RTT rings in shared memory; the build's own stdout is passed through"""
+        name = f"etf_rtt_{os.getpid()}"
+        env = dict(os.environ, RTT_SHM_NAME=f"/{name}")
+        try:
+            process = subprocess.Popen([self.host_exec], env=env)
+        except OSError as e:
+            print(f"[RTT_MONITOR] ERROR: Failed to start host build: {e}")
+            return False
+        
+        self.process = SharedMemoryTerminal(process, name, self.captures)
+        if self.flow:
+            self.flow.send = lambda data: self.process.write_down(CreditGranter.DOWN_CHANNEL, data)
+        print(f"[RTT_MONITOR] Started host build: {self.host_exec} (RTT in shared memory /{name})")
+        return True
+    
+    @property
+    def rtt_address(self) -> Optional[int]:
+        return self.rtt_manifest['control_block']['address'] if self.rtt_manifest else None
+    
+    def start_direct_terminal(self) -> bool:
+        """Channel 0 at the manifest's control block address, without the RAM search"""
+        self.jlink = open_jlink(self.device, self.interface, self.speed, self.rtt_address,
+                                "--rtt-manifest")
+        if not self.jlink:
+            return False
+        self.process = DirectTerminal(self.jlink)
+        print(f"[RTT_MONITOR] Attached to the RTT control block at 0x{self.rtt_address:08x}")
+        return True
     
     def start_rtt_viewer(self):
         """Start J-Link RTT Viewer process"""
+        if self.host_exec:
+            return self.start_host_process()
+        
+        if self.rtt_manifest:
+            if self.start_direct_terminal():
+                return True
+            print("[RTT_MONITOR] WARNING: falling back to JLinkRTTClient, which searches RAM for the control block")
+        
         cmd = [
             "JLinkRTTClient",
             "-Device", self.device,
@@ -78,17 +1212,60 @@ class RTTMonitor:
             print(f"[RTT_MONITOR] ERROR: Failed to start RTT viewer: {e}")
             return False
     
-    def parse_rtt_line(self, line: str):
-        """Parse a single RTT output line"""
+    def parse_rtt_line(self, line: str, host_time: Optional[float] = None,
+                       target_cycles: Optional[int] = None):
+        """Parse a single RTT output line; decoded compressed lines bring their own unwrapped cycles"""
         line = line.strip()
         if not line:
             return
         
+        if host_time is None:
+            host_time = time.time()
+        
+        # The previous session's tail belongs to another run, so none of it is parsed
+        if line.startswith('PM:'):
+            if self.postmortem is not None and self.postmortem['state'] == 'cut':
+                self.postmortem['lines'].append(line[3:])
+            print(f"[POSTMORTEM] {line[3:]}")
+            return None
+        
+        postmortem_match = self.postmortem_pattern.match(line)
+        if postmortem_match:
+            kind, fields = postmortem_match.groups()
+            self.handle_postmortem(kind, [int(f) for f in fields.split(':')[1:]])
+            return None
+        
+        # Clock sync records anchor target cycles to host time
+        sync_match = self.sync_pattern.search(line)
+        if sync_match:
+            sequence, cycles = map(int, sync_match.groups())
+            self.clock.add_sync(sequence, cycles, host_time)
+            return None
+        
         # Store all log messages
-        self.log_buffer.append({
-            'timestamp': datetime.now().isoformat(),
+        entry = {
+            'timestamp': datetime.fromtimestamp(host_time).isoformat(),
             'raw': line
-        })
+        }
+        log_match = self.log_pattern.search(line)
+        if log_match:
+            # Compressed lines arrive out of order with channel 0, so they must not move the unwrap
+            if target_cycles is None:
+                target_cycles = self.clock.unwrap(int(log_match.group(1)))
+            entry['target_cycles'] = target_cycles
+            self.record_log_latency(entry['target_cycles'], log_match.group(2), host_time)
+            sample_match = self.sample_tag_pattern.match(log_match.group(4))
+            if sample_match:
+                self.record_log_sample(sample_match.group(2), int(sample_match.group(1)))
+            format_check_match = self.format_check_pattern.match(log_match.group(4))
+            if format_check_match:
+                self.check_format_line(int(format_check_match.group(1)), format_check_match.group(2))
+        self.log_buffer.append(entry)
+        
+        crash_match = CRASH_PATTERN.match(line)
+        if crash_match:
+            self.handle_crash(*crash_match.groups())
+            return None
         
         # Parse status messages
         status_match = self.status_pattern.search(line)
@@ -96,6 +1273,8 @@ class RTTMonitor:
             status_str, test_name = status_match.groups()
             try:
                 status = TestStatus(status_str)
+                if status == TestStatus.RUNNING:
+                    self.current_test = test_name
                 if test_name not in self.test_results:
                     self.test_results[test_name] = TestResult(test_name, status)
                 else:
@@ -105,16 +1284,187 @@ class RTTMonitor:
             except ValueError:
                 print(f"[RTT_MONITOR] Unknown status: {status_str}")
         
+        # Parse target configuration
+        config_match = self.config_pattern.search(line)
+        if config_match:
+            key, value = config_match.groups()
+            if key == "CPU_HZ":
+                self.clock.cpu_hz = int(value)
+                # The init SYNC comes first and was fitted at the default rate
+                if self.clock.points:
+                    self.clock.fit()
+                self.occupancy.cpu_hz = int(value)
+            elif key == "REPEAT":
+                self.target_repeat = int(value)
+                if self.repeat > 1 and self.target_repeat != self.repeat:
+                    print(f"[RTT_MONITOR] WARNING: firmware built with REPEAT={self.target_repeat}, "
+                          f"expected {self.repeat}")
+            elif key == "SOAK" and int(value) and not self.soak:
+                print("[RTT_MONITOR] WARNING: firmware runs in soak mode, pass --soak")
+            return None
+        
+        log_limit_match = self.log_limit_pattern.search(line)
+        if log_limit_match:
+            file, line_number, suppressed = log_limit_match.groups()
+            site = self.log_limits.setdefault(f"{file}:{line_number}", {'suppressed': 0, 'tests': {}})
+            site['suppressed'] += int(suppressed)
+            test = self.current_test or '(none)'
+            site['tests'][test] = site['tests'].get(test, 0) + int(suppressed)
+            return None
+        
+        log_suppress_match = self.log_suppress_pattern.search(line)
+        if log_suppress_match:
+            rate_limited, repeats = map(int, log_suppress_match.groups())
+            self.log_suppressed = {'rate_limited': rate_limited, 'repeats': repeats}
+            return None
+        
+        logz_match = self.logz_pattern.search(line)
+        if logz_match:
+            records, nbytes, definitions, fallbacks = map(int, logz_match.groups())
+            self.logz_target = {'records': records, 'bytes': nbytes,
+                                'definitions': definitions, 'fallbacks': fallbacks}
+            return None
+        
+        log_defer_match = self.log_defer_pattern.search(line)
+        if log_defer_match:
+            queued, dropped, max_depth, depth = map(int, log_defer_match.groups())
+            self.log_defer = {'queued': queued, 'dropped': dropped, 'max_depth': max_depth, 'depth': depth}
+            return None
+        
+        log_sample_match = self.log_sample_pattern.search(line)
+        if log_sample_match:
+            file, line_number, rate, calls, emitted = log_sample_match.groups()
+            site = self.log_sample_site(f"{file}:{line_number}")
+            site['rate'] = int(rate)
+            site['calls'] = int(calls)
+            site['emitted'] = int(emitted)
+            return None
+        
+        kv_match = self.kv_pattern.search(line)
+        if kv_match:
+            self.handle_kv(kv_match, host_time)
+            return None
+        
+        func_trace_match = self.func_trace_pattern.search(line)
+        if func_trace_match:
+            records, dropped = map(int, func_trace_match.groups())
+            print(f"[FUNC_TRACE] {records} records, {dropped} dropped")
+            return None
+        
+        profile_match = self.profile_pattern.search(line)
+        if profile_match:
+            samples, dropped, rate = map(int, profile_match.groups())
+            print(f"[PROFILE] {samples} samples at {rate} Hz, {dropped} dropped")
+            return None
+        
+        coverage_match = self.coverage_pattern.search(line)
+        if coverage_match:
+            files, size, pool_failures = map(int, coverage_match.groups())
+            print(f"[COVERAGE] {files} .gcda files, {size} bytes")
+            if pool_failures:
+                print(f"[COVERAGE] WARNING: {pool_failures} allocations failed, raise TEST_COVERAGE_POOL_SIZE")
+            return None
+        
+        bulk_match = self.bulk_pattern.search(line)
+        if bulk_match:
+            dumps, raw, encoded, cycles, dropped = (int(g or 0) for g in bulk_match.groups())
+            seconds = cycles / self.clock.cpu_hz
+            rate = f", {encoded / seconds / 1024:.1f} KiB/s on the link" if seconds > 0 else ""
+            print(f"[BULK] {dumps} dumps, {raw} bytes ({encoded} sent){rate}")
+            if dropped:
+                print(f"[BULK] WARNING: {dropped} dumps dropped for lack of room on channel 5")
+            return None
+        
+        trace_stat_match = self.trace_stat_pattern.search(line)
+        if trace_stat_match:
+            events, dropped, names = map(int, trace_stat_match.groups())
+            print(f"[TRACE] {events} events, {dropped} dropped, {names} names")
+            return None
+        
+        # Parse metric snapshots
+        metrics_match = self.metrics_pattern.search(line)
+        if metrics_match:
+            scope, count, dropped = metrics_match.groups()
+            self.metrics_scope = scope
+            self.metrics[scope] = {}
+            if int(dropped) > 0:
+                print(f"[RTT_MONITOR] WARNING: {dropped} metric(s) not registered, raise TEST_METRICS_MAX")
+            return None
+        
+        metric_match = self.metric_pattern.search(line)
+        if metric_match:
+            self.handle_metric(*metric_match.groups())
+            return None
+        
+        # Parse soak snapshots (counters are cumulative since boot)
+        soak_match = self.soak_pattern.search(line)
+        if soak_match:
+            self.handle_soak_snapshot(*map(int, soak_match.groups()))
+            return None
+        
+        occupancy_match = self.occupancy_pattern.search(line)
+        if occupancy_match:
+            name, size, writes, dropped, high_water, near_full, hist = occupancy_match.groups()
+            self.occupancy.add(name, int(size), int(writes), int(dropped), int(high_water),
+                               int(near_full), hist)
+            return None
+        
+        flow_match = self.flow_pattern.search(line)
+        if flow_match:
+            channel, window, sent, consumed, grants, records, nbytes, bad = map(int, flow_match.groups())
+            self.flow_stats[channel] = {
+                'window': window,
+                'sent': sent,
+                'consumed': consumed,
+                'grants': grants,
+                'throttled_records': records,
+                'throttled_bytes': nbytes,
+                'bad_grants': bad,
+            }
+            return None
+        
+        write_stats_match = self.write_stats_pattern.search(line)
+        if write_stats_match:
+            record_class = write_stats_match.group(1)
+            policy, written, trimmed, dropped, timeouts, blocked, max_blocked = \
+                map(int, write_stats_match.groups()[1:])
+            self.write_stats[record_class] = {
+                'policy': WRITE_POLICIES.get(policy, str(policy)),
+                'written': written,
+                'trimmed': trimmed,
+                'dropped': dropped,
+                'timeouts': timeouts,
+                'blocked_cycles': blocked,
+                'max_block_cycles': max_blocked,
+            }
+            return None
+        
+        soak_test_match = self.soak_test_pattern.search(line)
+        if soak_test_match:
+            name, runs, passed, failed, min_c, max_c, hist = soak_test_match.groups()
+            histogram = {}
+            for pair in filter(None, hist.split(',')):
+                bucket, count = pair.split('=')
+                histogram[int(bucket)] = int(count)
+            self.soak_tests[name] = SoakTestAggregate(name, int(runs), int(passed), int(failed),
+                                                      int(min_c), int(max_c), histogram)
+            return None
+        
         # Parse result messages
         result_match = self.result_pattern.search(line)
         if result_match:
-            test_name, result_str, duration = result_match.groups()
+            test_name, result_str, duration, cycles, blocked = result_match.groups()
             status = TestStatus.PASS if result_str == "PASS" else TestStatus.FAIL
             
             if test_name in self.test_results:
                 self.test_results[test_name].status = status
                 self.test_results[test_name].duration_ms = int(duration)
             
+            self.test_runs.setdefault(test_name, []).append(
+                TestRun(status == TestStatus.PASS, int(duration),
+                        int(cycles) if cycles is not None else None,
+                        int(blocked) if blocked is not None else 0))
+            
             print(f"[TEST_RESULT] {test_name}: {result_str} ({duration}ms)")
         
         # Parse summary
@@ -132,13 +1482,330 @@ class RTTMonitor:
         # Parse regular log messages
         log_match = self.log_pattern.search(line)
         if log_match:
-            timestamp, level, message = log_match.groups()
+            timestamp, write_cycles, level, message = log_match.groups()
             print(f"[{level}] {message}")
         else:
             print(f"[RTT] {line}")
         
         return None
     
+    def handle_postmortem(self, kind: str, fields: List[int]):
+        """Retained-log report from a boot with POSTMORTEM=1 (see test_postmortem.h)"""
+        if kind == 'END':
+            return
+        if kind == 'BEGIN' and self.test_results:
+            print(f"[RTT_MONITOR] WARNING: target reset during the run (boot {fields[0]} was cut short)")
+        
+        if kind == 'BEGIN':
+            boot, kept, lost = fields
+            self.postmortem = {'state': 'cut', 'boot': boot, 'kept_bytes': kept, 'lost_bytes': lost, 'lines': []}
+            print(f"[RTT_MONITOR] Boot {boot} ended without a summary; its last {kept} bytes of output follow")
+        elif kind == 'CLEAN':
+            self.postmortem = {'state': 'clean', 'boot': fields[0]}
+        elif kind == 'CORRUPT':
+            self.postmortem = {'state': 'corrupt'}
+            print("[RTT_MONITOR] WARNING: post-mortem log header failed its CRC; previous session lost")
+        else:
+            self.postmortem = {'state': 'cold'}
+    
+    def decode_crash(self, hex_text: str, test_name: str, prefix: str) -> Optional[dict]:
+        """Decode, symbolize and print a crash record (make FAULT=1, see test_fault.h)"""
+        try:
+            crash = CrashRecord.parse(hex_text, test_name)
+        except (CrashRecordError, ValueError) as e:
+            print(f"[RTT_MONITOR] WARNING: undecodable crash record: {e}")
+            return None
+        symbols = load_symbols(self.elf, self.toolchain_prefix)
+        if symbols:
+            crash.symbolize(symbols)
+        crash.print_report(prefix)
+        return crash.to_dict()
+    
+    def handle_crash(self, hex_text: str, test_name: str):
+        """The target faulted: the running test fails and the session ends here"""
+        self.crash = self.decode_crash(hex_text, test_name, "[CRASH]") or {'test': test_name or None}
+        if test_name:
+            result = self.test_results.setdefault(test_name, TestResult(test_name, TestStatus.FAIL))
+            result.status = TestStatus.FAIL
+            print(f"[TEST_RESULT] {test_name}: FAIL (crashed)")
+    
+    def handle_kv(self, match, host_time: float):
+        cycles, level, event, rest = match.groups()
+        level = LOG_LEVELS[int(level)] if int(level) < len(LOG_LEVELS) else level
+        event = unquote(event)
+        
+        fields = []
+        for token in rest.split():
+            if token == '...':
+                self.kv.truncated += 1
+                continue
+            key, _, typed = token.partition('=')
+            kind, _, text = typed.partition(':')
+            try:
+                fields.append((unquote(key), kind, KVStore.decode(kind, text)))
+            except ValueError:
+                print(f"[RTT_MONITOR] WARNING: bad KV field {token!r} in {event}")
+        
+        self.kv.insert(event, self.clock.unwrap(int(cycles)), host_time, level, self.current_test, fields)
+        print(f"[{level}] " + " ".join([event] + [f"{key}={value}" for key, _, value in fields]))
+    
+    def log_sample_site(self, site: str) -> Dict:
+        return self.log_samples.setdefault(site, {'rate': 1, 'lines': 0, 'estimated_calls': 0,
+                                                  'calls': None, 'emitted': None, 'tests': {}})
+    
+    def record_log_sample(self, site_name: str, rate: int):
+        """A TEST_LOG_SAMPLED line stands for 'rate' calls at its site"""
+        site = self.log_sample_site(site_name)
+        site['rate'] = rate
+        site['lines'] += 1
+        site['estimated_calls'] += rate
+        test = self.current_test or '(none)'
+        site['tests'][test] = site['tests'].get(test, 0) + rate
+    
+    def check_format_line(self, length: int, text: str):
+        """FMTCHECK:<n>:<expected><output>|: the n-character expected text, then the same
+        conversion as it arrived, after the compressor and decoder when COMPRESS=1"""
+        expected, output = text[:length], text[length:]
+        self.format_checks['lines'] += 1
+        if output != expected + '|':
+            output = output[:-1] if output.endswith('|') else output
+            self.format_checks['mismatches'].append({'expected': expected, 'received': output})
+            print(f"[RTT_MONITOR] ERROR: format check expected '{expected}', received '{output}'")
+    
+    def print_format_checks(self):
+        """Lines from tests/test_format_cases.c and tests/test_log_cpp.cpp that did not survive the trip to the host"""
+        if not self.format_checks['lines']:
+            return
+        mismatches = len(self.format_checks['mismatches'])
+        print(f"[RTT_MONITOR] Format check: {self.format_checks['lines'] - mismatches}/"
+              f"{self.format_checks['lines']} lines received as formatted on the target")
+    
+    def print_log_sampling(self):
+        """Sampled sites with their call counts scaled back up from the lines received"""
+        if not self.log_samples:
+            return
+        print("[RTT_MONITOR] Sampled log sites (lines received x rate = estimated calls):")
+        for site, stats in sorted(self.log_samples.items(), key=lambda item: -item[1]['estimated_calls']):
+            exact = f", target counted {stats['calls']}" if stats['calls'] is not None else ""
+            print(f"  {site:40} 1/{stats['rate']:<5} {stats['lines']:>6} lines "
+                  f"~{stats['estimated_calls']:>8} calls{exact}")
+    
+    def poll_compressed_log(self):
+        """Decode whatever the compressed log capture gained and handle it like channel 0 lines"""
+        if not self.logz:
+            return
+        if self.logz_file is None:
+            try:
+                self.logz_file = open(self.logz_path, 'rb')
+            except FileNotFoundError:
+                return
+        data = self.logz_file.read()
+        if data:
+            received = time.time()
+            for cycles, line in self.logz.feed(data):
+                self.parse_rtt_line(line, received, cycles)
+    
+    def print_log_compression(self):
+        """Bytes per line on the compressed channel against the same lines as text"""
+        if not self.logz or not self.logz.lines:
+            return
+        report = self.logz.report()
+        ratio = report['text_bytes'] / report['bytes'] if report['bytes'] else 0.0
+        print(f"[RTT_MONITOR] Log compression: {report['lines']} lines in {report['bytes']} bytes, "
+              f"{report['bytes_per_line']:.1f} bytes/line vs {report['text_bytes_per_line']:.1f} as text "
+              f"({ratio:.2f}x, {report['formats']} formats sent)")
+        print(f"[RTT_MONITOR] Without the {report['definition_bytes']} bytes of format definitions: "
+              f"{report['line_bytes_per_line']:.1f} bytes/line")
+        if self.logz_target and self.logz_target['fallbacks']:
+            print(f"[RTT_MONITOR] {self.logz_target['fallbacks']} lines fell back to text on channel 0")
+        # The report comes before SUMMARY, so lines logged after it only add to the decoded count
+        if self.logz_target and self.logz_target['records'] > report['lines']:
+            print(f"[RTT_MONITOR] WARNING: target sent {self.logz_target['records']} compressed lines, "
+                  f"{report['lines']} decoded")
+        if report['errors']:
+            print(f"[RTT_MONITOR] WARNING: {report['errors']} bytes of the compressed log could not be decoded")
+    
+    def print_postmortem(self):
+        """Where the previous session stopped, from the lines it left in .noinit"""
+        if not self.postmortem or self.postmortem['state'] != 'cut':
+            return
+        lines = self.postmortem['lines']
+        
+        running = None
+        for line in lines:
+            status_match = self.status_pattern.match(line)
+            if status_match:
+                status, test_name = status_match.groups()
+                running = test_name if status == TestStatus.RUNNING.value else None
+        
+        where = f"during '{running}'" if running else "outside a test"
+        print(f"[RTT_MONITOR] Post-mortem: boot {self.postmortem['boot']} reset {where}, "
+              f"{len(lines)} lines kept ({self.postmortem['lost_bytes']} older bytes overwritten)")
+        if lines:
+            print(f"  last line: {lines[-1]}")
+        self.postmortem['running_test'] = running
+        
+        for line in lines:
+            crash_match = CRASH_PATTERN.match(line)
+            if crash_match:
+                self.postmortem['crash'] = self.decode_crash(*crash_match.groups(), "[POSTMORTEM]")
+    
+    def print_log_defer(self):
+        """Deferred log queue (make DEFER=1): how full it got and what it dropped"""
+        if not self.log_defer:
+            return
+        stats = self.log_defer
+        print(f"[RTT_MONITOR] Deferred log queue: {stats['queued']} lines queued, "
+              f"peak {stats['max_depth']}/{stats['depth']} records")
+        if stats['dropped']:
+            print(f"[RTT_MONITOR] WARNING: {stats['dropped']} log lines dropped on a full queue; "
+                  f"call test_log_drain() more often or raise TEST_LOG_DEFER_DEPTH")
+    
+    def print_log_suppression(self):
+        """Lines the target held back: per-site rate limits and collapsed repeats"""
+        if not self.log_suppressed and not self.log_limits:
+            return
+        totals = self.log_suppressed or {'rate_limited': 0, 'repeats': 0}
+        print(f"[RTT_MONITOR] Log suppression: {totals['rate_limited']} lines rate limited, "
+              f"{totals['repeats']} repeats collapsed")
+        for site, stats in sorted(self.log_limits.items(), key=lambda item: -item[1]['suppressed']):
+            worst = max(stats['tests'], key=stats['tests'].get)
+            print(f"  {site:40} {stats['suppressed']:>8} suppressed (most in {worst})")
+    
+    def print_write_stats(self):
+        """Per-class channel 0 write outcomes; loss in a blocking class is an error"""
+        lossy = {c: s for c, s in self.write_stats.items()
+                 if s['trimmed'] or s['dropped'] or s['timeouts']}
+        if not lossy:
+            return
+        
+        print("[RTT_MONITOR] Terminal write losses:")
+        print(f"  {'Class':<8} {'Policy':<6} {'Written':>8} {'Trimmed':>8} {'Dropped':>8} "
+              f"{'Timeouts':>8} {'Max block ms':>12}")
+        for record_class, stats in lossy.items():
+            max_block_ms = stats['max_block_cycles'] * 1000.0 / self.clock.cpu_hz
+            print(f"  {record_class:<8} {stats['policy']:<6} {stats['written']:>8} {stats['trimmed']:>8} "
+                  f"{stats['dropped']:>8} {stats['timeouts']:>8} {max_block_ms:>12.2f}")
+            if stats['policy'] == 'BLOCK' and stats['dropped']:
+                print(f"[RTT_MONITOR] WARNING: {stats['dropped']} {record_class} lines lost after "
+                      f"block timeouts; results may be incomplete (raise RTT_UP_SIZE or the timeout)")
+    
+    def print_flow_stats(self):
+        """Per-channel flow control: what the target held back for lack of credit"""
+        if not self.flow_stats:
+            return
+        
+        print("[RTT_MONITOR] Flow control:")
+        for channel, stats in sorted(self.flow_stats.items()):
+            state = "no grants received" if stats['grants'] == 0 else f"{stats['grants']} grants"
+            print(f"  Channel {channel}: window {stats['window']} bytes, sent {stats['sent']}, "
+                  f"throttled {stats['throttled_records']} records ({stats['throttled_bytes']} bytes), {state}")
+        if any(s['bad_grants'] for s in self.flow_stats.values()):
+            print("[RTT_MONITOR] WARNING: target ignored grants for channels it does not flow-control")
+    
+    def record_log_latency(self, emit_cycles: int, write_cycles: Optional[str], host_time: float):
+        """Split TEST_LOG_* latency into on-target formatting and transport"""
+        if self.clock.sync_count < 2:
+            return
+        
+        commit_cycles = emit_cycles
+        if write_cycles is not None:
+            commit_cycles += int(write_cycles)
+            self.latency.record("target_write", int(write_cycles) / self.clock.cpu_hz)
+        
+        emit_host = self.clock.to_host_time(emit_cycles)
+        commit_host = self.clock.to_host_time(commit_cycles)
+        self.latency.record("terminal", host_time - emit_host)
+        self.latency.record("terminal_transport", host_time - commit_host)
+    
+    def handle_metric(self, kind: str, name: str, fields: str):
+        """Decode one METRIC line into the current snapshot scope"""
+        values = fields.split(':')
+        scope = self.metrics.setdefault(self.metrics_scope or "unscoped", {})
+        
+        if kind == 'C':
+            scope[name] = {'type': 'counter', 'value': int(values[0])}
+        elif kind == 'G':
+            scope[name] = {'type': 'gauge', 'value': int(values[0]),
+                           'min': int(values[1]), 'max': int(values[2])}
+        elif kind == 'H':
+            sub_bits, count, mean, min_v, max_v = map(int, values[:5])
+            buckets = {}
+            for pair in filter(None, values[5].split(',') if len(values) > 5 else []):
+                index, bucket_count = pair.split('=')
+                buckets[int(index)] = int(bucket_count)
+            
+            def clamp(v):
+                return min(max(v, min_v), max_v)
+            
+            scope[name] = {
+                'type': 'histogram',
+                'count': count,
+                'mean': mean,
+                'min': min_v,
+                'max': max_v,
+                'p50': clamp(hist_percentile(buckets, sub_bits, 50)),
+                'p90': clamp(hist_percentile(buckets, sub_bits, 90)),
+                'p99': clamp(hist_percentile(buckets, sub_bits, 99)),
+                'sub_bits': sub_bits,
+                'buckets': buckets
+            }
+    
+    def print_metrics(self, scope: str):
+        """Print one metrics snapshot"""
+        print(f"[METRICS] {scope}:")
+        for name, metric in self.metrics.get(scope, {}).items():
+            if metric['type'] == 'counter':
+                print(f"  {name} = {metric['value']}")
+            elif metric['type'] == 'gauge':
+                print(f"  {name} = {metric['value']} (min {metric['min']}, max {metric['max']})")
+            else:
+                print(f"  {name}: n={metric['count']} mean={metric['mean']} p50={metric['p50']} "
+                      f"p90={metric['p90']} p99={metric['p99']} max={metric['max']}")
+    
+    def handle_soak_snapshot(self, iterations, elapsed_ms, total, passed, failed,
+                             errors, warnings, untracked):
+        """Replace the rolling aggregate with a new snapshot and report the interval"""
+        self.soak_previous = self.soak_snapshot
+        self.soak_snapshot = {
+            'iterations': iterations,
+            'elapsed_ms': elapsed_ms,
+            'total': total,
+            'passed': passed,
+            'failed': failed,
+            'errors': errors,
+            'warnings': warnings,
+            'untracked_tests': untracked
+        }
+        self.soak_snapshots_seen += 1
+        
+        prev = self.soak_previous or dict.fromkeys(self.soak_snapshot, 0)
+        new_failures = failed - prev['failed']
+        interval_s = max(elapsed_ms - prev['elapsed_ms'], 1) / 1000
+        rate = (iterations - prev['iterations']) / interval_s
+        
+        print(f"[SOAK] {elapsed_ms / 3600000:.2f}h iter={iterations} ({rate:.1f}/s) "
+              f"runs={total} fail={failed} (+{new_failures}) errors={errors} warnings={warnings}")
+        if new_failures > 0:
+            print(f"[SOAK] WARNING: {new_failures} new failure(s) in the last interval")
+    
+    def soak_report(self) -> dict:
+        """Rolling soak aggregates for the results file"""
+        return {
+            'snapshots': self.soak_snapshots_seen,
+            'latest': self.soak_snapshot,
+            'tests': {name: {
+                'runs': agg.runs,
+                'passed': agg.passed,
+                'failed': agg.failed,
+                'min_cycles': agg.min_cycles,
+                'max_cycles': agg.max_cycles,
+                'p50_cycles': agg.percentile(50),
+                'p99_cycles': agg.percentile(99),
+                'histogram_log2': agg.histogram
+            } for name, agg in self.soak_tests.items()}
+        }
+    
     def check_success_condition(self) -> bool:
         """Check if success conditions are met"""
         for condition in self.success_conditions:
@@ -155,11 +1822,92 @@ class RTTMonitor:
                     print(f"[RTT_MONITOR] Error in success condition: {e}")
         return False
     
+    def compute_repeat_stats(self) -> Dict[str, dict]:
+        """Pass rate and duration distribution per test over repeated runs"""
+        stats = {}
+        expected = self.target_repeat or self.repeat
+        
+        for name, runs in self.test_runs.items():
+            passes = sum(1 for r in runs if r.passed)
+            
+            # Prefer cycle counts; millisecond durations are too coarse for variance
+            if all(r.duration_cycles is not None for r in runs):
+                durations = [r.duration_cycles for r in runs]
+                unit = "cycles"
+            else:
+                durations = [r.duration_ms for r in runs]
+                unit = "ms"
+            
+            mean = sum(durations) / len(durations)
+            if len(durations) > 1:
+                variance = sum((d - mean) ** 2 for d in durations) / (len(durations) - 1)
+            else:
+                variance = 0.0
+            stddev = math.sqrt(variance)
+            cv = stddev / mean if mean > 0 else 0.0
+            
+            stats[name] = {
+                'runs': len(runs),
+                'passed': passes,
+                'pass_rate': passes / len(runs) * 100,
+                'unit': unit,
+                'mean': mean,
+                'stddev': stddev,
+                'cv': cv,
+                'min': min(durations),
+                'max': max(durations),
+                'blocked_cycles_max': max(r.blocked_cycles for r in runs),
+                'flaky': 0 < passes < len(runs),
+                'timing_unstable': len(runs) > 1 and cv > self.cv_threshold,
+                'incomplete': len(runs) < expected
+            }
+        
+        return stats
+    
+    def print_repeat_stats(self, stats: Dict[str, dict]):
+        """Print the per-test repeat report"""
+        print(f"[RTT_MONITOR] Repeat statistics ({self.target_repeat or self.repeat} runs per test):")
+        for name, st in stats.items():
+            flags = []
+            if st['flaky']:
+                flags.append("FLAKY")
+            if st['timing_unstable']:
+                flags.append("TIMING_UNSTABLE")
+            if st['incomplete']:
+                flags.append("INCOMPLETE")
+            print(f"  {name}: {st['passed']}/{st['runs']} passed ({st['pass_rate']:.1f}%), "
+                  f"mean {st['mean']:.1f} {st['unit']}, stddev {st['stddev']:.1f}, "
+                  f"CV {st['cv']:.3f} {' '.join(flags)}")
+            if st['blocked_cycles_max']:
+                print(f"    up to {st['blocked_cycles_max']} cycles blocked on the host per run (excluded)")
+    
+    def target_time_us(self, unwrapped_cycles: int) -> float:
+        """Absolute microseconds through the clock fit, else relative to reset"""
+        host_time = self.clock.to_host_time(unwrapped_cycles)
+        if host_time is not None:
+            return host_time * 1e6
+        return unwrapped_cycles * 1e6 / self.clock.cpu_hz
+    
     def monitor_until_success(self, timeout_seconds=60):
         """Monitor RTT output until success condition is met"""
         if not self.start_rtt_viewer():
             return False
         
+        if not self.host_exec:
+            for capture in self.captures:
+                capture.start(self.device, self.interface, self.speed, self.rtt_address)
+            if self.flow:
+                if not self.jlink:
+                    self.jlink = open_jlink(self.device, self.interface, self.speed,
+                                            self.rtt_address, "--flow")
+                if self.jlink:
+                    self.flow.connect(self.jlink)
+                else:
+                    self.flow = None
+        
+        if self.flow:
+            self.flow.start()
+        
         start_time = time.time()
         summary_data = None
         
@@ -167,23 +1915,37 @@ class RTTMonitor:
             print(f"[RTT_MONITOR] Monitoring for {timeout_seconds}s or until success condition...")
             
             while time.time() - start_time < timeout_seconds:
-                if self.process.poll() is not None:
+                # A host build's remaining output is still read after it exits
+                if self.process.poll() is not None and not self.host_exec:
                     print("[RTT_MONITOR] RTT process terminated")
                     break
                 
                 # Read available output
                 try:
                     line = self.process.stdout.readline()
+                    # Compressed lines were written before this one; keep them in order
+                    self.poll_compressed_log()
                     if line:
-                        result = self.parse_rtt_line(line)
+                        received = time.time()
+                        result = self.parse_rtt_line(line, received)
+                        self.latency.record("host_processing", time.time() - received)
                         if result and 'total' in result:
                             summary_data = result
                         
-                        # Check success condition after each line
-                        if self.check_success_condition():
+                        # The target spins (or resets) in its fault handler; nothing more comes from this run
+                        if self.crash:
+                            print("[RTT_MONITOR] Target crashed, stopping")
+                            break
+                        
+                        # Check success condition after each line; the end-of-suite
+                        # reports all come before SUMMARY, so none is cut off
+                        if summary_data and self.check_success_condition():
                             print("[RTT_MONITOR] Success condition met!")
                             time.sleep(1)  # Allow final messages
                             break
+                    elif self.host_exec and self.process.poll() is not None:
+                        print("[RTT_MONITOR] Host process exited")
+                        break
                     else:
                         time.sleep(0.1)  # Small delay if no output
                         
@@ -201,6 +1963,15 @@ class RTTMonitor:
     
     def stop_monitoring(self):
         """Stop RTT monitoring"""
+        if self.flow:
+            self.flow.stop()
+        
+        for capture in self.captures:
+            capture.stop()
+        self.poll_compressed_log()
+        
+        self.kv.close()
+        
         if self.process:
             self.process.terminate()
             try:
@@ -208,6 +1979,22 @@ class RTTMonitor:
             except subprocess.TimeoutExpired:
                 self.process.kill()
             print("[RTT_MONITOR] RTT monitoring stopped")
+        
+        if self.jlink:
+            self.jlink.close()
+            self.jlink = None
+    
+    def corrected_log_buffer(self) -> List[dict]:
+        """Log entries with target timestamps mapped through the final clock fit"""
+        entries = []
+        for entry in self.log_buffer:
+            entry = dict(entry)
+            if 'target_cycles' in entry:
+                host_time = self.clock.to_host_time(entry['target_cycles'])
+                if host_time is not None:
+                    entry['target_timestamp'] = datetime.fromtimestamp(host_time).isoformat(timespec='microseconds')
+            entries.append(entry)
+        return entries
     
     def save_results(self, filename="test_results.json"):
         """Save test results to JSON file"""
@@ -219,7 +2006,11 @@ class RTTMonitor:
                 'timestamp': result.timestamp,
                 'log_messages': result.log_messages
             } for name, result in self.test_results.items()},
-            'log_buffer': self.log_buffer,
+            'log_buffer': self.corrected_log_buffer(),
+            'clock': self.clock.report(),
+            'latency': self.latency.report(),
+            'repeat_stats': self.compute_repeat_stats(),
+            'metrics': self.metrics,
             'summary': {
                 'total_tests': len(self.test_results),
                 'passed_tests': sum(1 for r in self.test_results.values() if r.status == TestStatus.PASS),
@@ -227,23 +2018,143 @@ class RTTMonitor:
             }
         }
         
+        if self.soak:
+            output_data['soak'] = self.soak_report()
+        
+        if self.write_stats:
+            output_data['write_stats'] = self.write_stats
+        
+        if self.flow_stats:
+            output_data['flow'] = self.flow_stats
+        
+        if self.kv.counts:
+            output_data['kv'] = self.kv.report()
+        
+        if self.log_suppressed or self.log_limits:
+            output_data['log_suppression'] = dict(self.log_suppressed or {}, sites=self.log_limits)
+        
+        if self.log_samples:
+            output_data['log_sampling'] = self.log_samples
+        
+        if self.log_defer:
+            output_data['log_defer'] = self.log_defer
+        
+        if self.format_checks['lines']:
+            output_data['format_check'] = self.format_checks
+        
+        if self.postmortem:
+            output_data['postmortem'] = self.postmortem
+        
+        if self.crash:
+            output_data['crash'] = self.crash
+        
+        if self.logz:
+            output_data['log_compression'] = dict(self.logz.report(), target=self.logz_target)
+        
+        if self.occupancy.tests:
+            output_data['occupancy'] = self.occupancy.report(self.loss_target)
+        
         with open(filename, 'w') as f:
             json.dump(output_data, f, indent=2)
         
         print(f"[RTT_MONITOR] Results saved to {filename}")
 
 def main():
-    if len(sys.argv) < 2:
-        print("Usage: python3 rtt_monitor.py <device> [interface] [speed] [timeout]")
-        print("Example: python3 rtt_monitor.py STM32F407VG SWD 4000 60")
-        sys.exit(1)
+    parser = argparse.ArgumentParser(
+        usage="python3 rtt_monitor.py <device> [interface] [speed] [timeout] [options]",
+        epilog="Example: python3 rtt_monitor.py STM32F407VG SWD 4000 60 --repeat 10")
+    parser.add_argument("device", nargs="?")
+    parser.add_argument("interface", nargs="?", default="SWD")
+    parser.add_argument("speed", nargs="?", type=int, default=4000)
+    parser.add_argument("timeout", nargs="?", type=int, default=60)
+    parser.add_argument("--repeat", type=int, default=1,
+                        help="Runs per test the firmware was built with (make REPEAT=N)")
+    parser.add_argument("--cv-threshold", type=float, default=0.1,
+                        help="Coefficient of variation above which a test is timing-unstable")
+    parser.add_argument("--latency", action="store_true",
+                        help="Print emit-to-receive latency distributions per channel")
+    parser.add_argument("--soak", action="store_true",
+                        help="Soak run (make SOAK=1): aggregate snapshots until timeout")
+    parser.add_argument("--trace", metavar="JSON",
+                        help="Capture the trace channel (make TRACE=1) and export Chrome/Perfetto JSON")
+    parser.add_argument("--trace-input", metavar="BIN",
+                        help="Decode an existing trace channel capture instead of monitoring")
+    parser.add_argument("--capture", action="append", default=[], metavar="CHANNEL:FILE",
+                        help="Capture a binary RTT up channel to a file (repeatable)")
+    parser.add_argument("--cpu-hz", type=int, default=168000000,
+                        help="Target clock for offline decoding (default: 168000000)")
+    parser.add_argument("--loss-target", type=float, default=0.0,
+                        help="Acceptable fraction of dropped log writes for the buffer-size recommendation")
+    parser.add_argument("--host-exec", metavar="PATH",
+                        help="Run a host build (make host) instead of connecting to a probe")
+    parser.add_argument("--host-transport", choices=["shm", "pipe"], default="pipe",
+                        help="How --host-exec output is read: RTT rings in shared memory, "
+                             "or channel 0 on stdout and the others through files (default: pipe)")
+    parser.add_argument("--flow", action="store_true",
+                        help="Grant flow-control credit for captured channels (make FLOW=1)")
+    parser.add_argument("--compressed-log", metavar="FILE",
+                        help="Capture the compressed log channel (make COMPRESS=1) to FILE and decode it")
+    parser.add_argument("--elf", metavar="PATH",
+                        help="Firmware ELF (or host executable) to symbolize crash records (make FAULT=1)")
+    parser.add_argument("--toolchain-prefix", default="arm-none-eabi-",
+                        help="Binutils prefix for --elf; use '' for host builds")
+    parser.add_argument("--rtt-manifest", metavar="JSON",
+                        help="RTT manifest written by the build (rtt_manifest.py): attach at its control block address")
+    parser.add_argument("--kv-db", metavar="PATH",
+                        help="SQLite database for TEST_LOG_KV records (default: logs/kv_<time>.db)")
+    args = parser.parse_args()
+    
+    if args.trace_input:
+        decoder = TraceDecoder()
+        with open(args.trace_input, 'rb') as f:
+            decoder.feed(f.read())
+        decoder.export_chrome_trace(args.trace or args.trace_input + ".json",
+                                    lambda cycles: cycles * 1e6 / args.cpu_hz)
+        return
+    
+    if not args.device and not args.host_exec:
+        parser.error("device is required unless --trace-input or --host-exec is given")
+    
+    device = args.device or "host"
+    timeout = args.timeout
+    started = datetime.now().strftime('%Y%m%d_%H%M%S')
     
-    device = sys.argv[1]
-    interface = sys.argv[2] if len(sys.argv) > 2 else "SWD"
-    speed = int(sys.argv[3]) if len(sys.argv) > 3 else 4000
-    timeout = int(sys.argv[4]) if len(sys.argv) > 4 else 60
+    monitor = RTTMonitor(device=device, interface=args.interface, speed=args.speed,
+                         repeat=args.repeat, cv_threshold=args.cv_threshold, soak=args.soak,
+                         host_exec=args.host_exec, kv_path=args.kv_db or f"logs/kv_{started}.db",
+                         host_transport=args.host_transport)
+    monitor.clock.cpu_hz = args.cpu_hz
+    monitor.occupancy.cpu_hz = args.cpu_hz
+    monitor.loss_target = args.loss_target
+    monitor.elf = args.elf
+    monitor.toolchain_prefix = args.toolchain_prefix
     
-    monitor = RTTMonitor(device=device, interface=interface, speed=speed)
+    if args.trace:
+        trace_capture = ChannelCapture(1, os.path.splitext(args.trace)[0] + ".bin")
+        monitor.captures.append(trace_capture)
+    
+    for spec in args.capture:
+        channel, path = spec.split(':', 1)
+        monitor.captures.append(ChannelCapture(int(channel), path))
+    
+    if args.compressed_log:
+        # The host shim and JLinkRTTLogger recreate it; a stale file would be read first
+        if os.path.exists(args.compressed_log):
+            os.remove(args.compressed_log)
+        monitor.captures.append(ChannelCapture(RTT_CHANNEL_LOGZ, args.compressed_log))
+        monitor.logz = CompressedLogDecoder()
+        monitor.logz_path = args.compressed_log
+    
+    if args.rtt_manifest and not args.host_exec:
+        monitor.rtt_manifest = load_manifest(args.rtt_manifest)
+        channels = {c['channel'] for c in monitor.rtt_manifest['up']}
+        for capture in monitor.captures:
+            if capture.channel not in channels:
+                print(f"[RTT_MONITOR] WARNING: channel {capture.channel} is not in {args.rtt_manifest}; "
+                      f"the firmware was built without it")
+    
+    if args.flow:
+        monitor.flow = CreditGranter(monitor.captures)
     
     print(f"[RTT_MONITOR] Starting RTT monitoring for {device}")
     summary = monitor.monitor_until_success(timeout_seconds=timeout)
@@ -255,7 +2166,55 @@ def main():
         print(f"  Failed: {summary['failed']}")
         print(f"  Success Rate: {summary['success_rate']:.1f}%")
     
+    if monitor.soak and monitor.soak_snapshot:
+        print(f"[RTT_MONITOR] Soak run: {monitor.soak_snapshot['iterations']} iterations, "
+              f"{monitor.soak_snapshot['failed']} failures")
+        for name, agg in monitor.soak_tests.items():
+            print(f"  {name}: {agg.passed}/{agg.runs} passed, "
+                  f"p50 {agg.percentile(50)} cycles, p99 {agg.percentile(99)}, max {agg.max_cycles}")
+    
+    if monitor.clock.sync_count >= 2:
+        clock = monitor.clock.report()
+        print(f"[RTT_MONITOR] Clock: target {clock['cpu_hz_estimated']:.0f} Hz "
+              f"({clock['drift_ppm']:+.1f} ppm), max receive delay {clock['max_receive_delay_ms']:.1f} ms")
+    
+    if args.latency:
+        monitor.latency.print_report()
+    
+    monitor.print_postmortem()
+    monitor.print_write_stats()
+    monitor.print_flow_stats()
+    monitor.print_log_suppression()
+    monitor.print_log_sampling()
+    monitor.print_log_defer()
+    monitor.print_log_compression()
+    monitor.print_format_checks()
+    
+    if monitor.kv.counts:
+        kv = monitor.kv.report()
+        print(f"[RTT_MONITOR] {kv['records']} KV records in {len(kv['events'])} event tables: {kv['database']}")
+        if kv['truncated']:
+            print(f"[RTT_MONITOR] WARNING: {kv['truncated']} KV records lost fields to TEST_WRITE_LINE_MAX")
+    
+    if monitor.occupancy.tests:
+        monitor.occupancy.print_report(args.loss_target)
+    
+    if monitor.metrics_scope:
+        monitor.print_metrics(monitor.metrics_scope)
+    
+    if monitor.repeat > 1 or (monitor.target_repeat or 1) > 1:
+        monitor.print_repeat_stats(monitor.compute_repeat_stats())
+    
+    if args.trace and os.path.exists(trace_capture.path):
+        decoder = TraceDecoder()
+        with open(trace_capture.path, 'rb') as f:
+            decoder.feed(f.read())
+        decoder.export_chrome_trace(args.trace, monitor.target_time_us)
+    
     monitor.save_results(f"logs/test_results_{datetime.now().strftime('%Y%m%d_%H%M%S')}.json")
+    
+    if monitor.format_checks['mismatches']:
+        sys.exit(1)
 
 if __name__ == "__main__":
     main()
\ No newline at end of file
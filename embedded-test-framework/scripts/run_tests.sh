@@ -10,6 +10,18 @@ DEVICE=""
 INTERFACE="SWD"
 SPEED="4000"
 TIMEOUT="60"
+REPEAT="1"
+SOAK=false
+LATENCY=false
+TRACE=false
+FUNC_TRACE=false
+PROFILE=false
+COVERAGE=false
+BULK=false
+COMPRESS=false
+LOSS_TARGET=""
+FLOW=false
+BENCH=false
 FIRMWARE_FILE=""
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
@@ -51,12 +63,25 @@ show_help() {
     echo "  -i, --interface IF      Debug interface (default: SWD)"
     echo "  -s, --speed SPEED       Debug speed in kHz (default: 4000)"
     echo "  -t, --timeout TIMEOUT   Test timeout in seconds (default: 60)"
+    echo "  -r, --repeat N          Runs per test the firmware was built with (default: 1)"
+    echo "      --soak             Soak run: aggregate snapshots until the timeout"
+    echo "      --latency          Report log emit-to-receive latency per channel"
+    echo "      --trace            Capture TRACE_* events and export Perfetto JSON"
+    echo "      --func-trace       Capture function entry/exit trace and symbolize with the ELF"
+    echo "      --profile          Capture PC samples; write a flat profile and folded stacks"
+    echo "      --coverage         Capture gcov data and write the .gcda files"
+    echo "      --bulk             Capture test_dump_binary() dumps and write them as .npy"
+    echo "      --compress         Decode compressed log lines from channel 6 (make COMPRESS=1)"
+    echo "      --loss-target X    Dropped-write fraction for the buffer-size recommendation"
+    echo "      --flow             Grant flow-control credit for captured channels (needs pylink)"
+    echo "      --bench            Firmware is a benchmark (make bench, make format-bench); print its table"
     echo "  -l, --logs-only        Only monitor RTT, don't flash firmware"
     echo "  -h, --help             Show this help"
     echo ""
     echo "Examples:"
     echo "  $0 -d STM32F407VG -f build/firmware.hex"
     echo "  $0 -d STM32F407VG -l  # Monitor only"
+    echo "  $0 -d STM32F407VG -f build/firmware.hex -r 20  # Flaky-test hunt"
     echo ""
 }
 
@@ -85,6 +110,54 @@ while [[ $# -gt 0 ]]; do
             TIMEOUT="$2"
             shift 2
             ;;
+        -r|--repeat)
+            REPEAT="$2"
+            shift 2
+            ;;
+        --soak)
+            SOAK=true
+            shift
+            ;;
+        --latency)
+            LATENCY=true
+            shift
+            ;;
+        --trace)
+            TRACE=true
+            shift
+            ;;
+        --func-trace)
+            FUNC_TRACE=true
+            shift
+            ;;
+        --profile)
+            PROFILE=true
+            shift
+            ;;
+        --coverage)
+            COVERAGE=true
+            shift
+            ;;
+        --bulk)
+            BULK=true
+            shift
+            ;;
+        --compress)
+            COMPRESS=true
+            shift
+            ;;
+        --loss-target)
+            LOSS_TARGET="$2"
+            shift 2
+            ;;
+        --flow)
+            FLOW=true
+            shift
+            ;;
+        --bench)
+            BENCH=true
+            shift
+            ;;
         -l|--logs-only)
             LOGS_ONLY=true
             shift
@@ -119,6 +192,12 @@ mkdir -p "$LOGS_DIR"
 
 print_status "Starting test execution for device: $DEVICE"
 print_status "Interface: $INTERFACE, Speed: ${SPEED}kHz, Timeout: ${TIMEOUT}s"
+if [[ "$SOAK" == true ]]; then
+    print_status "Soak mode: aggregating snapshots for ${TIMEOUT}s"
+fi
+if [[ "$REPEAT" -gt 1 ]]; then
+    print_status "Repeat mode: each test runs $REPEAT times"
+fi
 
 # Function to flash firmware
 flash_firmware() {
@@ -200,10 +279,81 @@ main() {
     local timestamp=$(date "+%Y%m%d_%H%M%S")
     local results_file="$LOGS_DIR/test_results_${timestamp}.json"
     
+    if [[ "$BENCH" == true ]]; then
+        if python3 "$SCRIPT_DIR/rtt_bench.py" "$DEVICE" "$INTERFACE" "$SPEED" "$TIMEOUT" \
+                --capture "$LOGS_DIR/bench_${timestamp}.bin" --json "$LOGS_DIR/rtt_bench_${timestamp}.json"; then
+            print_success "Benchmark completed"
+            exit 0
+        fi
+        print_error "Benchmark failed or timed out"
+        exit 1
+    fi
+    
+    local monitor_args=(--repeat "$REPEAT" --kv-db "$LOGS_DIR/kv_${timestamp}.db")
+    if [[ "$SOAK" == true ]]; then
+        monitor_args+=(--soak)
+    fi
+    if [[ "$LATENCY" == true ]]; then
+        monitor_args+=(--latency)
+    fi
+    if [[ -n "$LOSS_TARGET" ]]; then
+        monitor_args+=(--loss-target "$LOSS_TARGET")
+    fi
+    if [[ "$FLOW" == true ]]; then
+        monitor_args+=(--flow)
+    fi
+    if [[ "$TRACE" == true ]]; then
+        monitor_args+=(--trace "$LOGS_DIR/trace_${timestamp}.json")
+    fi
+    local func_trace_file="$LOGS_DIR/functrace_${timestamp}.bin"
+    if [[ "$FUNC_TRACE" == true ]]; then
+        monitor_args+=(--capture "2:$func_trace_file")
+    fi
+    local profile_file="$LOGS_DIR/profile_${timestamp}.bin"
+    if [[ "$PROFILE" == true ]]; then
+        monitor_args+=(--capture "3:$profile_file")
+    fi
+    local coverage_file="$LOGS_DIR/coverage_${timestamp}.bin"
+    if [[ "$COVERAGE" == true ]]; then
+        monitor_args+=(--capture "4:$coverage_file")
+    fi
+    local bulk_file="$LOGS_DIR/bulk_${timestamp}.bin"
+    if [[ "$BULK" == true ]]; then
+        monitor_args+=(--capture "5:$bulk_file")
+    fi
+    if [[ "$COMPRESS" == true ]]; then
+        monitor_args+=(--compressed-log "$LOGS_DIR/logz_${timestamp}.bin")
+    fi
+    # Written next to the ELF at link time: attach at the control block instead of searching RAM
+    if [[ -f "${FIRMWARE_FILE%.*}.rtt.json" ]]; then
+        monitor_args+=(--rtt-manifest "${FIRMWARE_FILE%.*}.rtt.json")
+    fi
+    # Symbolizes a crash record (FAULT=1) as soon as it arrives
+    if [[ -f "${FIRMWARE_FILE%.*}.elf" ]]; then
+        monitor_args+=(--elf "${FIRMWARE_FILE%.*}.elf")
+    fi
+    
     # Run RTT monitor with Python script
-    if python3 "$SCRIPT_DIR/rtt_monitor.py" "$DEVICE" "$INTERFACE" "$SPEED" "$TIMEOUT"; then
+    if python3 "$SCRIPT_DIR/rtt_monitor.py" "$DEVICE" "$INTERFACE" "$SPEED" "$TIMEOUT" "${monitor_args[@]}"; then
         print_success "Test execution completed successfully"
         
+        local elf_file="${FIRMWARE_FILE%.*}.elf"
+        if [[ "$FUNC_TRACE" == true ]] && [[ -f "$func_trace_file" ]] && [[ -f "$elf_file" ]]; then
+            python3 "$SCRIPT_DIR/func_trace.py" "$func_trace_file" "$elf_file" \
+                --json "$LOGS_DIR/functrace_${timestamp}.json" || print_warning "Function trace analysis failed"
+        fi
+        if [[ "$PROFILE" == true ]] && [[ -f "$profile_file" ]] && [[ -f "$elf_file" ]]; then
+            python3 "$SCRIPT_DIR/pc_profile.py" "$profile_file" "$elf_file" \
+                --folded "$LOGS_DIR/profile_${timestamp}.folded" || print_warning "Profile analysis failed"
+        fi
+        if [[ "$COVERAGE" == true ]] && [[ -f "$coverage_file" ]]; then
+            python3 "$SCRIPT_DIR/coverage.py" extract "$coverage_file" || print_warning "Coverage extraction failed"
+        fi
+        if [[ "$BULK" == true ]] && [[ -f "$bulk_file" ]]; then
+            python3 "$SCRIPT_DIR/bulk_dump.py" "$bulk_file" --output-dir "$LOGS_DIR/bulk_${timestamp}" \
+                || print_warning "Bulk dump extraction failed"
+        fi
+        
         # Move results file to timestamped location
         if [[ -f "$PROJECT_ROOT/logs/test_results_*.json" ]]; then
             mv "$PROJECT_ROOT"/logs/test_results_*.json "$results_file"
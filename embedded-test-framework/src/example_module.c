@@ -1,24 +1,35 @@
 #include "example_module.h"
 #include "test_rtt_logger.h"
+#include "test_metrics.h"
+#include "test_trace.h"
 
 static uint32_t system_tick_counter = 0;
 static bool system_initialized = false;
 
+static TEST_COUNTER_DEFINE(tick_calls, "get_system_tick.calls");
+static TEST_GAUGE_DEFINE(tick_value, "get_system_tick.value");
+static TEST_HISTOGRAM_DEFINE(sum_cycles, "calculate_sum.cycles");
+
 void system_init(void) {
+    TRACE_BEGIN("system_init");
     TEST_LOG_INFO("Initializing system...");
     
     system_tick_counter = 0;
     system_initialized = true;
     
     TEST_LOG_INFO("System initialization complete");
+    TRACE_END("system_init");
 }
 
 uint32_t get_system_tick(void) {
+    TEST_COUNTER_INC(tick_calls);
+    
     if (!system_initialized) {
         TEST_LOG_ERROR("System not initialized!");
         return 0;
     }
     
+    TEST_GAUGE_SET(tick_value, (int32_t)system_tick_counter);
     return system_tick_counter++;
 }
 
@@ -27,32 +38,38 @@ bool is_system_ready(void) {
 }
 
 int32_t calculate_sum(int32_t a, int32_t b) {
-    TEST_LOG_DEBUG("Calculating sum: %ld + %ld", a, b);
+    uint32_t start_cycles = test_get_cycles();
+    
+    TEST_LOG_SAMPLED(TEST_LOG_LEVEL_DEBUG, 4, "Calculating sum: %" PRId32 " + %" PRId32, a, b);
     
     int64_t result = (int64_t)a + (int64_t)b;
     
     if (result > INT32_MAX || result < INT32_MIN) {
-        TEST_LOG_ERROR("Integer overflow in sum calculation");
+        TEST_LOG_KV(TEST_LOG_LEVEL_ERROR, "calculate_sum", "a", a, "b", b, "overflow", true);
+        TEST_HISTOGRAM_RECORD(sum_cycles, test_get_cycles() - start_cycles);
         return 0;
     }
     
-    TEST_LOG_DEBUG("Sum result: %ld", (int32_t)result);
+    TEST_LOG_KV(TEST_LOG_LEVEL_DEBUG, "calculate_sum", "a", a, "b", b, "result", (int32_t)result,
+                "overflow", false);
+    TEST_HISTOGRAM_RECORD(sum_cycles, test_get_cycles() - start_cycles);
     return (int32_t)result;
 }
 
 bool validate_range(int32_t value, int32_t min, int32_t max) {
-    TEST_LOG_DEBUG("Validating range: %ld in [%ld, %ld]", value, min, max);
+    TEST_LOG_DEBUG("Validating range: %" PRId32 " in [%" PRId32 ", %" PRId32 "]", value, min, max);
     
     bool valid = (value >= min) && (value <= max);
     
     if (!valid) {
-        TEST_LOG_WARN("Value %ld out of range [%ld, %ld]", value, min, max);
+        TEST_LOG_WARN("Value %" PRId32 " out of range [%" PRId32 ", %" PRId32 "]", value, min, max);
     }
     
     return valid;
 }
 
 void reset_system(void) {
+    TRACE_INSTANT("reset_system");
     TEST_LOG_INFO("Resetting system...");
     
     system_tick_counter = 0;
@@ -0,0 +1,212 @@
+#include "test_bulk.h"
+#include "test_rtt_logger.h"
+#include "test_flow.h"
+#include <string.h>
+
+#if TEST_BULK_ENABLED
+
+#define RLE_MAX_LITERAL 128u
+#define RLE_MIN_RUN     3u
+#define RLE_MAX_RUN     (0x7Fu + RLE_MIN_RUN)
+
+#define FRAME_HEADER    5u
+#define NAME_MAX        255u
+#define FRAME_MAX       (FRAME_HEADER + (TEST_BULK_CHUNK > 10u + NAME_MAX ? TEST_BULK_CHUNK : 10u + NAME_MAX))
+
+typedef struct {
+    uint8_t stage[TEST_BULK_CHUNK];
+    uint32_t staged;
+    uint32_t encoded;
+    uint8_t literals[RLE_MAX_LITERAL];
+    uint32_t literal_count;
+    uint8_t run_byte;
+    uint32_t run_length;
+} bulk_encoder_t;
+
+static const uint8_t element_sizes[] = { 1, 1, 2, 2, 4, 4, 4 };
+
+static char bulk_buffer[RTT_BUFFER_BULK_SIZE];
+static uint8_t bulk_frame_buffer[FRAME_MAX];
+static bulk_encoder_t encoder;
+static bool bulk_lost = false;      /* a frame of the current dump did not fit */
+static uint32_t bulk_sequence = 0;
+static uint32_t bulk_dropped = 0;
+static uint32_t bulk_raw_bytes = 0;
+static uint32_t bulk_encoded_bytes = 0;
+static uint32_t bulk_cycles = 0;
+
+void test_bulk_init(void) {
+    /* SKIP mode keeps frames whole: a frame is written completely or not at all */
+    SEGGER_RTT_ConfigUpBuffer(RTT_CHANNEL_BULK, "Bulk", bulk_buffer,
+                              sizeof(bulk_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    test_flow_register(RTT_CHANNEL_BULK, sizeof(bulk_buffer));
+}
+
+/* One write per frame; after the first frame that does not fit, the rest of the dump is dropped */
+static void bulk_frame(uint8_t tag, const void* payload, uint32_t length) {
+    if (bulk_lost) {
+        return;
+    }
+
+    bulk_frame_buffer[0] = tag;
+    bulk_frame_buffer[1] = (uint8_t)length;
+    bulk_frame_buffer[2] = (uint8_t)(length >> 8);
+    bulk_frame_buffer[3] = (uint8_t)(length >> 16);
+    bulk_frame_buffer[4] = (uint8_t)(length >> 24);
+    memcpy(bulk_frame_buffer + FRAME_HEADER, payload, length);
+
+    const unsigned total = (unsigned)(FRAME_HEADER + length);
+    if (test_flow_write(RTT_CHANNEL_BULK, bulk_frame_buffer, total) != total) {
+        bulk_lost = true;
+    }
+}
+
+static void stage_flush(void) {
+    if (encoder.staged > 0) {
+        bulk_frame(TEST_BULK_TAG_DATA, encoder.stage, encoder.staged);
+        encoder.encoded += encoder.staged;
+        encoder.staged = 0;
+    }
+}
+
+static void stage_byte(uint8_t value) {
+    encoder.stage[encoder.staged++] = value;
+    if (encoder.staged == sizeof(encoder.stage)) {
+        stage_flush();
+    }
+}
+
+static void rle_flush_literals(void) {
+    if (encoder.literal_count > 0) {
+        stage_byte((uint8_t)(encoder.literal_count - 1u));
+        for (uint32_t i = 0; i < encoder.literal_count; i++) {
+            stage_byte(encoder.literals[i]);
+        }
+        encoder.literal_count = 0;
+    }
+}
+
+static void rle_flush_run(void) {
+    if (encoder.run_length >= RLE_MIN_RUN) {
+        rle_flush_literals();
+        stage_byte((uint8_t)(0x80u + encoder.run_length - RLE_MIN_RUN));
+        stage_byte(encoder.run_byte);
+    } else {
+        /* Runs too short to pay for a control byte stay literal */
+        for (uint32_t i = 0; i < encoder.run_length; i++) {
+            encoder.literals[encoder.literal_count++] = encoder.run_byte;
+            if (encoder.literal_count == RLE_MAX_LITERAL) {
+                rle_flush_literals();
+            }
+        }
+    }
+    encoder.run_length = 0;
+}
+
+static void encode_byte(uint8_t value, uint8_t flags) {
+    if ((flags & TEST_BULK_RLE) == 0) {
+        stage_byte(value);
+        return;
+    }
+    if (encoder.run_length > 0 && value == encoder.run_byte && encoder.run_length < RLE_MAX_RUN) {
+        encoder.run_length++;
+        return;
+    }
+    rle_flush_run();
+    encoder.run_byte = value;
+    encoder.run_length = 1;
+}
+
+static void encode_elements(const uint8_t* data, uint32_t count, uint32_t size, uint8_t flags) {
+    uint32_t previous = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t value = 0;
+        memcpy(&value, data + i * size, size);     /* little-endian target */
+
+        uint32_t out = value;
+        if (flags & TEST_BULK_DELTA) {
+            out = value - previous;
+            previous = value;
+        }
+        for (uint32_t b = 0; b < size; b++) {
+            encode_byte((uint8_t)(out >> (8u * b)), flags);
+        }
+    }
+
+    if (flags & TEST_BULK_RLE) {
+        rle_flush_run();
+        rle_flush_literals();
+    }
+    stage_flush();
+}
+
+/* Unencoded dumps skip the encoder; chunks after the first are word-aligned */
+static void send_raw(const uint8_t* data, uint32_t length) {
+    uint32_t chunk = TEST_BULK_CHUNK - ((uintptr_t)data & 3u);
+
+    while (length > 0) {
+        if (chunk > length) {
+            chunk = length;
+        }
+        bulk_frame(TEST_BULK_TAG_DATA, data, chunk);
+        encoder.encoded += chunk;
+        data += chunk;
+        length -= chunk;
+        chunk = TEST_BULK_CHUNK;
+    }
+}
+
+bool test_dump_array(const char* tag, const void* data, uint32_t count, uint8_t type, uint8_t flags) {
+    uint8_t header[10 + NAME_MAX];
+    const uint32_t start = test_get_cycles();
+    const uint32_t size = type < sizeof(element_sizes) ? element_sizes[type] : 1u;
+    const uint32_t raw = count * size;
+    size_t name_length = strlen(tag);
+    uint32_t footer[2];
+
+    if (name_length > NAME_MAX) {
+        name_length = NAME_MAX;
+    }
+
+    bulk_lost = false;
+    header[0] = type;
+    header[1] = flags;
+    memcpy(&header[2], &count, sizeof(count));
+    memcpy(&header[6], &bulk_sequence, sizeof(bulk_sequence));
+    memcpy(&header[10], tag, name_length);
+    bulk_frame(TEST_BULK_TAG_HEADER, header, (uint32_t)(10 + name_length));
+
+    memset(&encoder, 0, sizeof(encoder));
+    if (flags == 0) {
+        send_raw((const uint8_t*)data, raw);
+    } else {
+        encode_elements((const uint8_t*)data, count, size, flags);
+    }
+
+    footer[0] = raw;
+    footer[1] = encoder.encoded;
+    bulk_frame(TEST_BULK_TAG_END, footer, sizeof(footer));
+
+    bulk_sequence++;
+    bulk_cycles += test_get_cycles() - start;
+    if (bulk_lost) {
+        bulk_dropped++;
+        return false;
+    }
+    bulk_raw_bytes += raw;
+    bulk_encoded_bytes += encoder.encoded;
+    return true;
+}
+
+bool test_dump_binary(const char* tag, const void* data, uint32_t length) {
+    return test_dump_array(tag, data, length, TEST_BULK_U8, TEST_BULK_DEFAULT_FLAGS);
+}
+
+/* BULK:dumps:raw:sent:cycles:dropped; the byte counts cover complete dumps only */
+void test_bulk_report(void) {
+    test_rtt_printf(TEST_RECORD_CONTROL, "BULK:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                    bulk_sequence - bulk_dropped, bulk_raw_bytes, bulk_encoded_bytes, bulk_cycles, bulk_dropped);
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "test_coverage.h"
+#include "test_rtt_logger.h"
+#include <string.h>
+
+#if TEST_COVERAGE_ENABLED
+
+#include <gcov.h>
+
+#define COVERAGE_STAGE_SIZE 128
+
+/* The dumper must not update counters while it serializes them */
+#define NO_PROFILE __attribute__((no_profile_instrument_function))
+
+extern const struct gcov_info* const __gcov_info_start[];
+extern const struct gcov_info* const __gcov_info_end[];
+
+typedef struct {
+    uint8_t stage[COVERAGE_STAGE_SIZE];
+    uint32_t staged;
+    uint32_t bytes;
+    uint32_t pool_used;
+    uint32_t pool_failures;
+} coverage_stream_t;
+
+static char coverage_buffer[RTT_BUFFER_COVERAGE_SIZE];
+static uint8_t coverage_pool[TEST_COVERAGE_POOL_SIZE] __attribute__((aligned(8)));
+
+NO_PROFILE void test_coverage_init(void) {
+    SEGGER_RTT_ConfigUpBuffer(RTT_CHANNEL_COVERAGE, "Coverage", coverage_buffer,
+                              sizeof(coverage_buffer), SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL);
+}
+
+NO_PROFILE static void coverage_frame(uint8_t tag, const void* payload, uint32_t length) {
+    uint8_t header[5];
+
+    header[0] = tag;
+    header[1] = (uint8_t)length;
+    header[2] = (uint8_t)(length >> 8);
+    header[3] = (uint8_t)(length >> 16);
+    header[4] = (uint8_t)(length >> 24);
+    SEGGER_RTT_Write(RTT_CHANNEL_COVERAGE, header, sizeof(header));
+    if (length > 0) {
+        SEGGER_RTT_Write(RTT_CHANNEL_COVERAGE, payload, length);
+    }
+}
+
+NO_PROFILE static void coverage_flush(coverage_stream_t* stream) {
+    if (stream->staged > 0) {
+        coverage_frame(TEST_COVERAGE_TAG_DATA, stream->stage, stream->staged);
+        stream->bytes += stream->staged;
+        stream->staged = 0;
+    }
+}
+
+NO_PROFILE static void coverage_filename(const char* filename, void* arg) {
+    coverage_stream_t* stream = (coverage_stream_t*)arg;
+    const char* name = filename != NULL ? filename : "";
+
+    coverage_flush(stream);
+    coverage_frame(TEST_COVERAGE_TAG_FILE, name, (uint32_t)strlen(name));
+}
+
+/* libgcov hands over the stream in 4-byte pieces; batch them into frames */
+NO_PROFILE static void coverage_data(const void* data, unsigned length, void* arg) {
+    coverage_stream_t* stream = (coverage_stream_t*)arg;
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    while (length > 0) {
+        uint32_t chunk = COVERAGE_STAGE_SIZE - stream->staged;
+        if (chunk > length) {
+            chunk = length;
+        }
+        memcpy(stream->stage + stream->staged, bytes, chunk);
+        stream->staged += chunk;
+        bytes += chunk;
+        length -= chunk;
+
+        if (stream->staged == COVERAGE_STAGE_SIZE) {
+            coverage_flush(stream);
+        }
+    }
+}
+
+NO_PROFILE static void* coverage_allocate(unsigned length, void* arg) {
+    coverage_stream_t* stream = (coverage_stream_t*)arg;
+    uint32_t aligned = (length + 7u) & ~7u;
+
+    if (stream->pool_used + aligned > sizeof(coverage_pool)) {
+        stream->pool_failures++;
+        return NULL;
+    }
+    void* block = &coverage_pool[stream->pool_used];
+    stream->pool_used += aligned;
+    return block;
+}
+
+NO_PROFILE void test_coverage_dump(void) {
+    coverage_stream_t stream;
+    uint32_t files = 0;
+
+    memset(&stream, 0, sizeof(stream));
+
+    for (const struct gcov_info* const* info = __gcov_info_start; info < __gcov_info_end; info++) {
+        __gcov_info_to_gcda(*info, coverage_filename, coverage_data, coverage_allocate, &stream);
+        coverage_flush(&stream);
+        stream.pool_used = 0;
+        files++;
+    }
+
+    coverage_frame(TEST_COVERAGE_TAG_END, &files, sizeof(files));
+
+    test_rtt_printf(TEST_RECORD_CONTROL, "COVERAGE:%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n", files, stream.bytes, stream.pool_failures);
+}
+
+#endif
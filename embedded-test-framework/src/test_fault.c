@@ -0,0 +1,198 @@
+#include "test_fault.h"
+#include "test_rtt_logger.h"
+#include <stddef.h>
+#include <string.h>
+
+#if TEST_FAULT_ENABLED
+
+#if TEST_HOST_BUILD
+#include <signal.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#define SCB_ICSR   (*(volatile uint32_t*)0xE000ED04u)
+#define SCB_AIRCR  (*(volatile uint32_t*)0xE000ED0Cu)
+#define SCB_SHCSR  (*(volatile uint32_t*)0xE000ED24u)
+#define SCB_CFSR   (*(volatile uint32_t*)0xE000ED28u)
+#define SCB_HFSR   (*(volatile uint32_t*)0xE000ED2Cu)
+#define SCB_MMFAR  (*(volatile uint32_t*)0xE000ED34u)
+#define SCB_BFAR   (*(volatile uint32_t*)0xE000ED38u)
+
+/* Static, like the line in fault_send(): the faulting stack may have no room left */
+static test_fault_record_t fault_record;
+
+/* CRASH:<hex>:<test>; the writer blocks (with its timeout) like any control line */
+static void fault_send(const test_fault_record_t* record) {
+    static const char hex[] = "0123456789abcdef";
+    static char line[TEST_WRITE_LINE_MAX];
+    const uint8_t* bytes = (const uint8_t*)record;
+    const size_t size = offsetof(test_fault_record_t, stack) + record->stack_words * sizeof(uint32_t);
+    const char* name = test_running(NULL);
+    size_t used = 6;
+
+    memcpy(line, "CRASH:", 6);
+    for (size_t i = 0; i < size; i++) {
+        line[used++] = hex[bytes[i] >> 4];
+        line[used++] = hex[bytes[i] & 0x0Fu];
+    }
+    line[used++] = ':';
+    if (name != NULL) {
+        const size_t length = strlen(name);
+        const size_t room = sizeof(line) - used - 2u;
+        memcpy(line + used, name, length < room ? length : room);
+        used += length < room ? length : room;
+    }
+    line[used++] = '\r';
+    line[used++] = '\n';
+    test_rtt_write(TEST_RECORD_CONTROL, line, (unsigned)used);
+}
+
+static void fault_snapshot(test_fault_record_t* record, const uint32_t* stack, uint32_t words) {
+    if (words > TEST_FAULT_STACK_WORDS) {
+        words = TEST_FAULT_STACK_WORDS;
+    }
+    for (uint32_t i = 0; i < words; i++) {
+        record->stack[i] = stack[i];
+    }
+    record->stack_words = (uint16_t)words;
+    record->test_index = 0;
+    test_running(&record->test_index);
+    record->cycles = test_get_cycles();
+}
+
+#if TEST_HOST_BUILD
+
+static char fault_signal_stack[16384];
+
+static void fault_signal(int signal_number, siginfo_t* info, void* context) {
+    const ucontext_t* uc = (const ucontext_t*)context;
+    test_fault_record_t* record = &fault_record;
+    const uint32_t* stack = NULL;
+
+    memset(record, 0, sizeof(*record));
+    record->version = TEST_FAULT_RECORD_VERSION;
+    record->kind = (uint8_t)(TEST_FAULT_HOST_SIGNAL | (unsigned)signal_number);
+
+    /* Registers are cut to 32 bits; -no-pie keeps code addresses below 4 GiB */
+#if defined(__x86_64__)
+    const greg_t* regs = uc->uc_mcontext.gregs;
+    record->r0 = (uint32_t)regs[REG_RDI];
+    record->r1 = (uint32_t)regs[REG_RSI];
+    record->r2 = (uint32_t)regs[REG_RDX];
+    record->r3 = (uint32_t)regs[REG_RCX];
+    record->r12 = (uint32_t)regs[REG_RBP];
+    record->pc = (uint32_t)regs[REG_RIP];
+    record->xpsr = (uint32_t)regs[REG_EFL];
+    stack = (const uint32_t*)regs[REG_RSP];
+#elif defined(__aarch64__)
+    record->r0 = (uint32_t)uc->uc_mcontext.regs[0];
+    record->r1 = (uint32_t)uc->uc_mcontext.regs[1];
+    record->r2 = (uint32_t)uc->uc_mcontext.regs[2];
+    record->r3 = (uint32_t)uc->uc_mcontext.regs[3];
+    record->r12 = (uint32_t)uc->uc_mcontext.regs[12];
+    record->lr = (uint32_t)uc->uc_mcontext.regs[30];
+    record->pc = (uint32_t)uc->uc_mcontext.pc;
+    record->xpsr = (uint32_t)uc->uc_mcontext.pstate;
+    stack = (const uint32_t*)uc->uc_mcontext.sp;
+#endif
+    record->sp = (uint32_t)(uintptr_t)stack;
+    record->cfsr = (uint32_t)info->si_code;
+    record->mmfar = (uint32_t)(uintptr_t)info->si_addr;
+
+    fault_snapshot(record, stack, stack != NULL ? TEST_FAULT_STACK_WORDS : 0u);
+    fault_send(record);
+    _exit(128 + signal_number);
+}
+
+void test_fault_init(void) {
+    static const int signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE };
+    struct sigaction action;
+    stack_t alternate;
+
+    /* A stack overflow leaves no stack for the handler itself */
+    alternate.ss_sp = fault_signal_stack;
+    alternate.ss_size = sizeof(fault_signal_stack);
+    alternate.ss_flags = 0;
+    sigaltstack(&alternate, NULL);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = fault_signal;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+        sigaction(signals[i], &action, NULL);
+    }
+}
+
+#else
+
+/* Top of the main stack in STM32CubeMX-style linker scripts; bounds the copy when defined */
+extern uint32_t _estack __attribute__((weak));
+
+void test_fault_init(void) {
+    /* MemManage, BusFault and UsageFault get their own vectors instead of escalating */
+    SCB_SHCSR |= (1u << 16) | (1u << 17) | (1u << 18);
+}
+
+void test_fault_handler(const uint32_t* frame, uint32_t exc_return) {
+    test_fault_record_t* record = &fault_record;
+
+    memset(record, 0, sizeof(*record));
+    record->version = TEST_FAULT_RECORD_VERSION;
+    record->kind = (uint8_t)(SCB_ICSR & 0x1FFu);       /* VECTACTIVE */
+    record->r0 = frame[0];
+    record->r1 = frame[1];
+    record->r2 = frame[2];
+    record->r3 = frame[3];
+    record->r12 = frame[4];
+    record->lr = frame[5];
+    record->pc = frame[6];
+    record->xpsr = frame[7];
+    record->exc_return = exc_return;
+    record->cfsr = SCB_CFSR;
+    record->hfsr = SCB_HFSR;
+    record->mmfar = SCB_MMFAR;
+    record->bfar = SCB_BFAR;
+
+    /* 8 words, 26 with FP state (EXC_RETURN bit 4 clear), plus one if xPSR bit 9 marks realignment */
+    const uint32_t* above = frame + ((exc_return & 0x10u) ? 8u : 26u) + ((frame[7] >> 9) & 1u);
+    uint32_t words = TEST_FAULT_STACK_WORDS;
+    if (&_estack != NULL && above < &_estack && (uint32_t)(&_estack - above) < words) {
+        words = (uint32_t)(&_estack - above);
+    }
+    record->sp = (uint32_t)(uintptr_t)above;
+
+    fault_snapshot(record, above, words);
+    fault_send(record);
+
+#if TEST_FAULT_RESET
+    SCB_AIRCR = 0x05FA0004u;    /* VECTKEY | SYSRESETREQ */
+#endif
+    for (;;) {
+    }
+}
+
+#if TEST_FAULT_INSTALL_HANDLERS
+/* Hand the stacked frame (MSP or PSP, per EXC_RETURN) and EXC_RETURN to the C handler */
+#define FAULT_ENTRY(name) \
+    __attribute__((naked)) void name(void) { \
+        __asm volatile( \
+            "tst lr, #4              \n" \
+            "ite eq                  \n" \
+            "mrseq r0, msp           \n" \
+            "mrsne r0, psp           \n" \
+            "mov r1, lr              \n" \
+            "b test_fault_handler    \n" \
+        ); \
+    }
+
+FAULT_ENTRY(HardFault_Handler)
+FAULT_ENTRY(MemManage_Handler)
+FAULT_ENTRY(BusFault_Handler)
+FAULT_ENTRY(UsageFault_Handler)
+#endif
+
+#endif
+
+#endif
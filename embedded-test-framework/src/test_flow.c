@@ -0,0 +1,118 @@
+#include "test_flow.h"
+#include "test_rtt_logger.h"
+#include <string.h>
+
+#if TEST_FLOW_ENABLED
+
+typedef struct {
+    uint32_t window;        /* 0: not flow-controlled */
+    uint32_t sent;          /* bytes written, wraps */
+    uint32_t consumed;      /* latest host grant, wraps */
+    bool granted;           /* a grant has arrived; throttle from now on */
+    uint32_t grants;
+    uint32_t throttled_records;
+    uint32_t throttled_bytes;
+} flow_channel_t;
+
+static char flow_down_buffer[RTT_BUFFER_FLOW_DOWN_SIZE];
+static flow_channel_t flow_channels[TEST_FLOW_MAX_CHANNELS];
+static uint8_t grant_bytes[TEST_FLOW_GRANT_SIZE];
+static unsigned grant_fill = 0;
+static uint32_t bad_grants = 0;
+
+void test_flow_init(void) {
+    SEGGER_RTT_ConfigDownBuffer(RTT_CHANNEL_FLOW_DOWN, "Credits", flow_down_buffer,
+                                sizeof(flow_down_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+void test_flow_register(unsigned channel, uint32_t window) {
+    if (channel < TEST_FLOW_MAX_CHANNELS) {
+        flow_channels[channel].window = window;
+    }
+}
+
+static void flow_apply_grant(void) {
+    const unsigned channel = grant_bytes[0];
+    uint32_t consumed;
+
+    memcpy(&consumed, &grant_bytes[1], sizeof(consumed));
+
+    if (channel >= TEST_FLOW_MAX_CHANNELS || flow_channels[channel].window == 0) {
+        bad_grants++;
+        return;
+    }
+
+    flow_channel_t* flow = &flow_channels[channel];
+    /* Grants are cumulative: a stale or repeated one never takes credit back */
+    if (!flow->granted || (int32_t)(consumed - flow->consumed) > 0) {
+        flow->consumed = consumed;
+    }
+    flow->granted = true;
+    flow->grants++;
+}
+
+void test_flow_poll(void) {
+    unsigned n;
+
+    /* Records may arrive split across reads */
+    while ((n = SEGGER_RTT_Read(RTT_CHANNEL_FLOW_DOWN, &grant_bytes[grant_fill],
+                                TEST_FLOW_GRANT_SIZE - grant_fill)) > 0) {
+        grant_fill += n;
+        if (grant_fill == TEST_FLOW_GRANT_SIZE) {
+            flow_apply_grant();
+            grant_fill = 0;
+        }
+    }
+}
+
+uint32_t test_flow_credit(unsigned channel) {
+    const flow_channel_t* flow = &flow_channels[channel];
+    const int32_t in_flight = (int32_t)(flow->sent - flow->consumed);
+
+    if (!flow->granted) {
+        return UINT32_MAX;
+    }
+    /* A host that reports more than was sent (a reset target) gets a full window */
+    if (in_flight <= 0) {
+        return flow->window;
+    }
+    return (uint32_t)in_flight >= flow->window ? 0u : flow->window - (uint32_t)in_flight;
+}
+
+unsigned test_flow_write(unsigned channel, const void* data, unsigned length) {
+    if (channel >= TEST_FLOW_MAX_CHANNELS || flow_channels[channel].window == 0) {
+        return SEGGER_RTT_Write(channel, data, length);
+    }
+
+    flow_channel_t* flow = &flow_channels[channel];
+
+    /* The down channel is only read when credit runs short */
+    if (test_flow_credit(channel) < length) {
+        test_flow_poll();
+        if (test_flow_credit(channel) < length) {
+            flow->throttled_records++;
+            flow->throttled_bytes += length;
+            return 0;
+        }
+    }
+
+    const unsigned written = SEGGER_RTT_Write(channel, data, length);
+    flow->sent += written;
+    return written;
+}
+
+void test_flow_report(void) {
+    test_flow_poll();
+    for (unsigned channel = 0; channel < TEST_FLOW_MAX_CHANNELS; channel++) {
+        const flow_channel_t* flow = &flow_channels[channel];
+
+        if (flow->window == 0) {
+            continue;
+        }
+        test_rtt_printf(TEST_RECORD_CONTROL, "FLOW:%u:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                        channel, flow->window, flow->sent, flow->consumed, flow->grants,
+                        flow->throttled_records, flow->throttled_bytes, bad_grants);
+    }
+}
+
+#endif
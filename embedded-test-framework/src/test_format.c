@@ -0,0 +1,481 @@
+#include "test_format.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define FLAG_LEFT    0x01u
+#define FLAG_ZERO    0x02u
+#define FLAG_PLUS    0x04u
+#define FLAG_SPACE   0x08u
+
+typedef struct {
+    char* out;
+    size_t size;
+    size_t length;
+} format_sink_t;
+
+/* Arguments come from a va_list or, for test_format_args(), an array */
+typedef struct {
+    va_list list;
+    const test_format_arg_t* array;
+    size_t count;
+    size_t next;
+} format_args_t;
+
+typedef struct {
+    unsigned flags;
+    int width;
+    int precision;      /* -1: none */
+} format_spec_t;
+
+static void put_char(format_sink_t* sink, char c) {
+    if (sink->length + 1u < sink->size) {
+        sink->out[sink->length] = c;
+    }
+    sink->length++;
+}
+
+/* Literal runs and strings go in one copy rather than a put_char() each */
+static void put_chars(format_sink_t* sink, const char* s, size_t count) {
+    if (sink->length + 1u < sink->size) {
+        const size_t room = sink->size - 1u - sink->length;
+        memcpy(sink->out + sink->length, s, count < room ? count : room);
+    }
+    sink->length += count;
+}
+
+static void put_repeat(format_sink_t* sink, char c, int count) {
+    while (count-- > 0) {
+        put_char(sink, c);
+    }
+}
+
+static void put_string(format_sink_t* sink, const format_spec_t* spec, const char* s) {
+    int length = 0;
+
+    if (s == NULL) {
+        s = "(null)";
+    }
+    if (spec->precision < 0) {
+        length = (int)strlen(s);
+    } else {
+        while (length < spec->precision && s[length] != '\0') {
+            length++;
+        }
+    }
+
+    if (!(spec->flags & FLAG_LEFT)) {
+        put_repeat(sink, ' ', spec->width - length);
+    }
+    put_chars(sink, s, (size_t)length);
+    if (spec->flags & FLAG_LEFT) {
+        put_repeat(sink, ' ', spec->width - length);
+    }
+}
+
+static const test_format_arg_t* next_array_arg(format_args_t* args) {
+    static const test_format_arg_t missing = { 0 };
+    return args->next < args->count ? &args->array[args->next++] : &missing;
+}
+
+/* Array arguments already hold the full value, so the length modifier is not applied */
+static int64_t next_signed(format_args_t* args, int longs, bool size_arg) {
+    if (args->array != NULL) {
+        return next_array_arg(args)->i;
+    }
+    if (longs < 0) {
+        const int value = va_arg(args->list, int);
+        return longs == -1 ? (short)value : (signed char)value;
+    }
+    if (longs >= 2) {
+        return va_arg(args->list, long long);
+    }
+    if (longs == 1 || size_arg) {
+        return va_arg(args->list, long);
+    }
+    return va_arg(args->list, int);
+}
+
+static uint64_t next_unsigned(format_args_t* args, int longs, bool size_arg) {
+    if (args->array != NULL) {
+        return next_array_arg(args)->u;
+    }
+    if (longs < 0) {
+        const unsigned value = va_arg(args->list, unsigned int);
+        return longs == -1 ? (unsigned short)value : (unsigned char)value;
+    }
+    if (longs >= 2) {
+        return va_arg(args->list, unsigned long long);
+    }
+    if (longs == 1 || size_arg) {
+        return va_arg(args->list, unsigned long);
+    }
+    return va_arg(args->list, unsigned int);
+}
+
+static const void* next_pointer(format_args_t* args) {
+    return args->array != NULL ? next_array_arg(args)->p : va_arg(args->list, const void*);
+}
+
+static const char* next_string(format_args_t* args) {
+    return args->array != NULL ? next_array_arg(args)->s : va_arg(args->list, const char*);
+}
+
+/* Digits in reverse; the 32-bit loop avoids a libgcc 64-bit division per digit */
+static int convert_digits(char* digits, uint64_t value, unsigned base, bool upper) {
+    const char* set = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    int count = 0;
+
+    while (value > UINT32_MAX) {
+        digits[count++] = set[value % base];
+        value /= base;
+    }
+    uint32_t small = (uint32_t)value;
+    do {
+        digits[count++] = set[small % base];
+        small /= base;
+    } while (small != 0);
+
+    return count;
+}
+
+static void put_integer(format_sink_t* sink, const format_spec_t* spec, uint64_t magnitude,
+                        bool negative, unsigned base, bool upper, const char* prefix) {
+    char digits[24];
+    int count = 0;
+    char sign = 0;
+
+    /* %.0d of zero prints nothing */
+    if (!(magnitude == 0 && spec->precision == 0)) {
+        count = convert_digits(digits, magnitude, base, upper);
+    }
+
+    if (negative) {
+        sign = '-';
+    } else if (spec->flags & FLAG_PLUS) {
+        sign = '+';
+    } else if (spec->flags & FLAG_SPACE) {
+        sign = ' ';
+    }
+
+    const int prefix_length = (int)strlen(prefix);
+
+    const int zeros = spec->precision > count ? spec->precision - count : 0;
+    int padding = spec->width - (count + zeros + prefix_length + (sign != 0 ? 1 : 0));
+    const bool zero_pad = (spec->flags & FLAG_ZERO) && !(spec->flags & FLAG_LEFT) && spec->precision < 0;
+
+    if (!(spec->flags & FLAG_LEFT) && !zero_pad) {
+        put_repeat(sink, ' ', padding);
+        padding = 0;
+    }
+    if (sign != 0) {
+        put_char(sink, sign);
+    }
+    put_chars(sink, prefix, (size_t)prefix_length);
+    if (zero_pad) {
+        put_repeat(sink, '0', padding);
+        padding = 0;
+    }
+    put_repeat(sink, '0', zeros);
+    while (count > 0) {
+        put_char(sink, digits[--count]);
+    }
+    put_repeat(sink, ' ', padding);
+}
+
+static int format_to(char* out, size_t size, const char* format, format_args_t* args) {
+    format_sink_t sink = { out, size, 0 };
+
+    while (*format != '\0') {
+        if (*format != '%') {
+            const char* run = format;
+            while (*format != '\0' && *format != '%') {
+                format++;
+            }
+            put_chars(&sink, run, (size_t)(format - run));
+            continue;
+        }
+        format++;
+
+        format_spec_t spec = { 0u, 0, -1 };
+        for (;; format++) {
+            if (*format == '-') {
+                spec.flags |= FLAG_LEFT;
+            } else if (*format == '0') {
+                spec.flags |= FLAG_ZERO;
+            } else if (*format == '+') {
+                spec.flags |= FLAG_PLUS;
+            } else if (*format == ' ') {
+                spec.flags |= FLAG_SPACE;
+            } else {
+                break;
+            }
+        }
+
+        if (*format == '*') {
+            spec.width = (int)next_signed(args, 0, false);
+            if (spec.width < 0) {
+                spec.flags |= FLAG_LEFT;
+                spec.width = -spec.width;
+            }
+            format++;
+        } else {
+            while (*format >= '0' && *format <= '9') {
+                spec.width = spec.width * 10 + (*format++ - '0');
+            }
+        }
+
+        if (*format == '.') {
+            format++;
+            spec.precision = 0;
+            if (*format == '*') {
+                spec.precision = (int)next_signed(args, 0, false);
+                format++;
+            } else {
+                while (*format >= '0' && *format <= '9') {
+                    spec.precision = spec.precision * 10 + (*format++ - '0');
+                }
+            }
+        }
+
+        /* Length: 'l' or more means at least long; 'h' (-1) and 'hh' (-2) narrow the promoted int */
+        int longs = 0;
+        bool size_arg = false;
+        for (;; format++) {
+            if (*format == 'l') {
+                longs++;
+            } else if (*format == 'z' || *format == 'j' || *format == 't') {
+                size_arg = true;
+                longs = (*format == 'j') ? 2 : longs;
+            } else if (*format == 'h') {
+                longs--;
+            } else {
+                break;
+            }
+        }
+
+        const char conversion = *format;
+        if (conversion == '\0') {
+            break;
+        }
+        format++;
+
+        switch (conversion) {
+            case 'd':
+            case 'i': {
+                const int64_t value = next_signed(args, longs, size_arg);
+                const uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+                put_integer(&sink, &spec, magnitude, value < 0, 10u, false, "");
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                const uint64_t value = next_unsigned(args, longs, size_arg);
+                const unsigned base = conversion == 'u' ? 10u : conversion == 'o' ? 8u : 16u;
+                spec.flags &= ~(FLAG_PLUS | FLAG_SPACE);
+                put_integer(&sink, &spec, value, false, base, conversion == 'X', "");
+                break;
+            }
+            case 'p':
+                spec.flags &= ~(FLAG_PLUS | FLAG_SPACE);
+                put_integer(&sink, &spec, (uintptr_t)next_pointer(args), false, 16u, false, "0x");
+                break;
+            case 'c':
+                if (!(spec.flags & FLAG_LEFT)) {
+                    put_repeat(&sink, ' ', spec.width - 1);
+                }
+                put_char(&sink, (char)next_signed(args, 0, false));
+                if (spec.flags & FLAG_LEFT) {
+                    put_repeat(&sink, ' ', spec.width - 1);
+                }
+                break;
+            case 's':
+                put_string(&sink, &spec, next_string(args));
+                break;
+            case '%':
+                put_char(&sink, '%');
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (args->array != NULL) {
+                    next_array_arg(args);
+                } else {
+                    (void)va_arg(args->list, double);
+                }
+                put_char(&sink, '?');
+                break;
+            default:
+                put_char(&sink, '%');
+                put_char(&sink, conversion);
+                break;
+        }
+    }
+
+    if (size > 0) {
+        out[sink.length < size ? sink.length : size - 1u] = '\0';
+    }
+    return (int)sink.length;
+}
+
+int test_vformat(char* out, size_t size, const char* format, va_list list) {
+    format_args_t args = { .array = NULL };
+    int length;
+
+    va_copy(args.list, list);
+    length = format_to(out, size, format, &args);
+    va_end(args.list);
+    return length;
+}
+
+int test_format_args(char* out, size_t size, const char* format,
+                     const test_format_arg_t* array, size_t count) {
+    format_args_t args = { .array = array, .count = count, .next = 0 };
+
+    return format_to(out, size, format, &args);
+}
+
+/* One conversion spec after its '%', for the walks that read arguments without formatting */
+typedef struct {
+    int stars;          /* '*' width and precision arguments ahead of the value */
+    int longs;          /* 'l' count, or -1 for 'h' and -2 for 'hh' */
+    bool size_arg;
+    char conversion;
+} spec_scan_t;
+
+static const char* scan_spec(const char* format, spec_scan_t* scan) {
+    scan->stars = 0;
+    scan->longs = 0;
+    scan->size_arg = false;
+
+    while (*format == '-' || *format == '0' || *format == '+' || *format == ' ') {
+        format++;
+    }
+    if (*format == '*') {
+        scan->stars++;
+        format++;
+    }
+    while (*format >= '0' && *format <= '9') {
+        format++;
+    }
+    if (*format == '.') {
+        format++;
+        if (*format == '*') {
+            scan->stars++;
+            format++;
+        }
+        while (*format >= '0' && *format <= '9') {
+            format++;
+        }
+    }
+    for (;; format++) {
+        if (*format == 'l') {
+            scan->longs++;
+        } else if (*format == 'z' || *format == 'j' || *format == 't') {
+            scan->size_arg = true;
+            scan->longs = (*format == 'j') ? 2 : scan->longs;
+        } else if (*format == 'h') {
+            scan->longs--;
+        } else {
+            break;
+        }
+    }
+
+    scan->conversion = *format;
+    return *format != '\0' ? format + 1 : format;
+}
+
+static bool is_float_conversion(char conversion) {
+    return conversion == 'f' || conversion == 'F' || conversion == 'e' || conversion == 'E' ||
+           conversion == 'g' || conversion == 'G' || conversion == 'a' || conversion == 'A';
+}
+
+size_t test_format_conversions(const char* format, char* out, size_t max) {
+    size_t count = 0;
+
+    while (count < max && (format = strchr(format, '%')) != NULL) {
+        spec_scan_t scan;
+
+        format = scan_spec(format + 1, &scan);
+        for (int i = 0; i < scan.stars && count < max; i++) {
+            out[count++] = '*';
+        }
+        if (scan.conversion == '\0') {
+            break;
+        }
+        if (scan.conversion == '%' || (strchr("diucxXops", scan.conversion) == NULL &&
+                                       !is_float_conversion(scan.conversion))) {
+            continue;
+        }
+        if (count < max) {
+            out[count++] = scan.conversion;
+        }
+    }
+    return count;
+}
+
+/* Same walk as format_to() without the output: each argument lands in one array slot */
+size_t test_format_capture(const char* format, va_list list, test_format_arg_t* out, size_t max) {
+    format_args_t args = { .array = NULL };
+    size_t count = 0;
+
+    va_copy(args.list, list);
+    while (count < max && (format = strchr(format, '%')) != NULL) {
+        spec_scan_t scan;
+
+        format = scan_spec(format + 1, &scan);
+        for (int i = 0; i < scan.stars && count < max; i++) {
+            out[count++].i = next_signed(&args, 0, false);
+        }
+        if (scan.conversion == '\0' || count >= max) {
+            break;
+        }
+
+        switch (scan.conversion) {
+            case 'd':
+            case 'i':
+                out[count++].i = next_signed(&args, scan.longs, scan.size_arg);
+                break;
+            case 'c':
+                out[count++].i = next_signed(&args, 0, false);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                out[count++].u = next_unsigned(&args, scan.longs, scan.size_arg);
+                break;
+            case 'p':
+                out[count++].p = next_pointer(&args);
+                break;
+            case 's':
+                out[count++].s = next_string(&args);
+                break;
+            default:
+                if (is_float_conversion(scan.conversion)) {
+                    (void)va_arg(args.list, double);
+                    out[count++].u = 0;
+                }
+                break;
+        }
+    }
+    va_end(args.list);
+    return count;
+}
+
+int test_format(char* out, size_t size, const char* format, ...) {
+    va_list args;
+    int length;
+
+    va_start(args, format);
+    length = test_vformat(out, size, format, args);
+    va_end(args);
+    return length;
+}
@@ -0,0 +1,70 @@
+#include "test_func_trace.h"
+#include "test_rtt_logger.h"
+#include "test_flow.h"
+
+#if TEST_FUNC_TRACE_ENABLED
+
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+
+static char func_trace_buffer[RTT_BUFFER_FUNC_TRACE_SIZE];
+static bool func_trace_active = false;
+static bool func_trace_lost = false;
+static uint32_t last_address = 0;
+static uint32_t last_cycles = 0;
+static uint32_t func_trace_records = 0;
+static uint32_t func_trace_dropped = 0;
+
+NO_INSTRUMENT void test_func_trace_init(void) {
+    SEGGER_RTT_ConfigUpBuffer(RTT_CHANNEL_FUNC_TRACE, "FuncTrace", func_trace_buffer,
+                              sizeof(func_trace_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    test_flow_register(RTT_CHANNEL_FUNC_TRACE, sizeof(func_trace_buffer));
+    last_address = 0;
+    last_cycles = TEST_DWT_CYCCNT;
+    func_trace_active = true;
+}
+
+NO_INSTRUMENT static void func_trace_record(uint32_t address, uint32_t exit_flag) {
+    uint32_t record[4];
+    unsigned words = 0;
+    uint32_t now = TEST_DWT_CYCCNT;     /* not test_get_cycles(): may be instrumented */
+    uint32_t base = last_address;
+
+    if (!func_trace_active) {
+        return;
+    }
+
+    if (func_trace_lost) {
+        record[words++] = 0;
+        record[words++] = TEST_FUNC_TRACE_LOSS_MARKER;
+        base = 0;
+    }
+
+    record[words++] = ((address - base) & ~1u) | exit_flag;
+    record[words++] = now - last_cycles;
+
+    if (test_flow_write(RTT_CHANNEL_FUNC_TRACE, record, words * 4u) == words * 4u) {
+        last_address = address;
+        last_cycles = now;
+        func_trace_lost = false;
+        func_trace_records++;
+    } else {
+        func_trace_lost = true;
+        func_trace_dropped++;
+    }
+}
+
+NO_INSTRUMENT void __cyg_profile_func_enter(void* this_fn, void* call_site) {
+    (void)call_site;
+    func_trace_record((uint32_t)(uintptr_t)this_fn, 0u);
+}
+
+NO_INSTRUMENT void __cyg_profile_func_exit(void* this_fn, void* call_site) {
+    (void)call_site;
+    func_trace_record((uint32_t)(uintptr_t)this_fn, 1u);
+}
+
+NO_INSTRUMENT void test_func_trace_report(void) {
+    test_rtt_printf(TEST_RECORD_CONTROL, "FUNCTRACE:%" PRIu32 ":%" PRIu32 "\r\n", func_trace_records, func_trace_dropped);
+}
+
+#endif
@@ -0,0 +1,199 @@
+#include "test_logz.h"
+#include "test_rtt_logger.h"
+#include "test_flow.h"
+#include <string.h>
+
+#if TEST_LOG_COMPRESS
+
+#if (TEST_LOGZ_DICT_SIZE & (TEST_LOGZ_DICT_SIZE - 1u)) != 0 || TEST_LOGZ_DICT_SIZE > 128u
+#error "TEST_LOGZ_DICT_SIZE must be a power of two no larger than 128"
+#endif
+
+/* Slots tried before a format is sent as text instead */
+#define LOGZ_MAX_PROBES 8u
+
+/* Definitions go out whole, so a format longer than this stays text */
+#define LOGZ_DEFINE_MAX 128u
+
+static char logz_buffer[RTT_BUFFER_LOGZ_SIZE];
+static const char* logz_dict[TEST_LOGZ_DICT_SIZE];
+static uint32_t logz_last_timestamp = 0;
+static uint32_t logz_records = 0;
+static uint32_t logz_bytes = 0;
+static uint32_t logz_definitions = 0;
+static uint32_t logz_fallbacks = 0;
+
+void test_logz_init(void) {
+    const uint8_t start = TEST_LOGZ_START;
+
+    SEGGER_RTT_ConfigUpBuffer(RTT_CHANNEL_LOGZ, "LogZ", logz_buffer,
+                              sizeof(logz_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    test_flow_register(RTT_CHANNEL_LOGZ, sizeof(logz_buffer));
+    test_flow_write(RTT_CHANNEL_LOGZ, &start, 1u);
+}
+
+/* used runs past the end on overflow so the caller can tell */
+static void put_byte(uint8_t* data, size_t size, size_t* used, uint8_t value) {
+    if (*used < size) {
+        data[*used] = value;
+    }
+    (*used)++;
+}
+
+static void put_varint(uint8_t* data, size_t size, size_t* used, uint64_t value) {
+    while (value >= 0x80u) {
+        put_byte(data, size, used, (uint8_t)(value | 0x80u));
+        value >>= 7;
+    }
+    put_byte(data, size, used, (uint8_t)value);
+}
+
+/* Small negative numbers stay short: 0, -1, 1, -2 ... become 0, 1, 2, 3 ... */
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+/* Slot holding format, or a free one to define it in; false when the probes run out */
+static bool dict_slot(const char* format, uint8_t* slot, bool* defined) {
+    uint32_t index = ((uint32_t)(uintptr_t)format * 2654435761u) >> 16;
+
+    for (uint32_t probe = 0; probe < LOGZ_MAX_PROBES; probe++, index++) {
+        const char* entry = logz_dict[index & (TEST_LOGZ_DICT_SIZE - 1u)];
+
+        if (entry == format || entry == NULL) {
+            *slot = (uint8_t)(index & (TEST_LOGZ_DICT_SIZE - 1u));
+            *defined = entry != NULL;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool dict_define(uint8_t slot, const char* format) {
+    uint8_t record[LOGZ_DEFINE_MAX];
+    const size_t length = strlen(format);
+    size_t used = 0;
+
+    put_byte(record, sizeof(record), &used, TEST_LOGZ_DEFINE);
+    put_varint(record, sizeof(record), &used, slot);
+    put_varint(record, sizeof(record), &used, length);
+    if (used + length > sizeof(record)) {
+        return false;
+    }
+    memcpy(record + used, format, length);
+    used += length;
+
+    if (test_flow_write(RTT_CHANNEL_LOGZ, record, (unsigned)used) != used) {
+        return false;
+    }
+    logz_dict[slot] = format;
+    logz_definitions++;
+    logz_bytes += (uint32_t)used;
+    return true;
+}
+
+bool test_logz_encode(test_logz_record_t* record, const char* format,
+                      const test_format_arg_t* args, size_t count) {
+    uint8_t* const body = record->data + TEST_LOGZ_HEADER_MAX;
+    char conversions[TEST_LOG_MAX_ARGS];
+    size_t used = 0;
+
+    record->format = format;
+    if (!dict_slot(format, &record->slot, &record->defined)) {
+        logz_fallbacks++;
+        return false;
+    }
+    put_byte(body, TEST_LOGZ_BODY_MAX, &used, record->slot);
+
+    const size_t conversion_count = test_format_conversions(format, conversions, sizeof(conversions));
+    for (size_t i = 0; i < conversion_count && i < count; i++) {
+        switch (conversions[i]) {
+            case '*':
+            case 'd':
+            case 'i':
+            case 'c':
+                put_varint(body, TEST_LOGZ_BODY_MAX, &used, zigzag(args[i].i));
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                put_varint(body, TEST_LOGZ_BODY_MAX, &used, args[i].u);
+                break;
+            case 'p':
+                put_varint(body, TEST_LOGZ_BODY_MAX, &used, (uintptr_t)args[i].p);
+                break;
+            case 's': {
+                const char* s = args[i].s != NULL ? args[i].s : "(null)";
+                size_t length = strlen(s);
+
+                /* A cut string still leaves room for its length byte and the rest */
+                const size_t room = used + 2u < TEST_LOGZ_BODY_MAX ? TEST_LOGZ_BODY_MAX - used - 2u : 0u;
+                if (length > room) {
+                    length = room;
+                }
+                put_varint(body, TEST_LOGZ_BODY_MAX, &used, length);
+                if (used + length <= TEST_LOGZ_BODY_MAX) {
+                    memcpy(body + used, s, length);
+                }
+                used += length;
+                break;
+            }
+            default:
+                /* Floating point: the decoder prints '?' like test_format() */
+                break;
+        }
+    }
+
+    if (used > TEST_LOGZ_BODY_MAX) {
+        logz_fallbacks++;
+        return false;
+    }
+    record->used = TEST_LOGZ_HEADER_MAX + used;
+    return true;
+}
+
+bool test_logz_send(test_logz_record_t* record, int level, uint32_t timestamp, uint32_t cost) {
+    uint8_t header[TEST_LOGZ_HEADER_MAX];
+    size_t length = 0;
+
+    if (!record->defined) {
+        if (!dict_define(record->slot, record->format)) {
+            logz_fallbacks++;
+            return false;
+        }
+        record->defined = true;
+    }
+
+#if TEST_LATENCY_PROBES
+    put_byte(header, sizeof(header), &length, (uint8_t)((level & 3) | TEST_LOGZ_COST));
+    put_varint(header, sizeof(header), &length, timestamp - logz_last_timestamp);
+    put_varint(header, sizeof(header), &length, cost);
+#else
+    (void)cost;
+    put_byte(header, sizeof(header), &length, (uint8_t)(level & 3));
+    put_varint(header, sizeof(header), &length, timestamp - logz_last_timestamp);
+#endif
+
+    /* The header goes right in front of the body, so the record is one write */
+    uint8_t* const start = record->data + TEST_LOGZ_HEADER_MAX - length;
+    const unsigned total = (unsigned)(record->used - TEST_LOGZ_HEADER_MAX + length);
+    memcpy(start, header, length);
+
+    if (test_flow_write(RTT_CHANNEL_LOGZ, start, total) != total) {
+        logz_fallbacks++;
+        return false;
+    }
+    logz_last_timestamp = timestamp;
+    logz_records++;
+    logz_bytes += total;
+    return true;
+}
+
+/* LOGZ:records:bytes:definitions:fallbacks */
+void test_logz_report(void) {
+    test_rtt_printf(TEST_RECORD_CONTROL, "LOGZ:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                    logz_records, logz_bytes, logz_definitions, logz_fallbacks);
+}
+
+#endif
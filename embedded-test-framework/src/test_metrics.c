@@ -0,0 +1,111 @@
+#include "test_metrics.h"
+#include "test_rtt_logger.h"
+#include <string.h>
+
+static test_metric_t* metrics[TEST_METRICS_MAX];
+static uint32_t metric_count = 0;
+static uint32_t metrics_dropped = 0;
+
+void test_metrics_register(test_metric_t* metric) {
+    if (metric->registered) {
+        return;
+    }
+
+    if (metric_count >= TEST_METRICS_MAX) {
+        metrics_dropped++;
+        return;
+    }
+
+    metric->registered = true;
+    metrics[metric_count++] = metric;
+}
+
+static void snapshot_histogram(const test_histogram_t* hist) {
+    char pair[24];
+    bool first = true;
+
+    test_rtt_printf(TEST_RECORD_CONTROL, "METRIC:H:%s:%u:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":",
+                   hist->base.name,
+                   (unsigned)TEST_HIST_SUB_BITS,
+                   hist->count,
+                   hist->count > 0 ? (uint32_t)(hist->sum / hist->count) : 0u,
+                   hist->count > 0 ? hist->min : 0u,
+                   hist->max);
+
+    /* Sparse bucket list, streamed pair by pair to keep stack usage small */
+    for (uint32_t i = 0; i < TEST_HIST_BUCKETS; i++) {
+        if (hist->buckets[i] != 0) {
+            int len = test_format(pair, sizeof(pair), "%s%" PRIu32 "=%" PRIu32, first ? "" : ",", i, hist->buckets[i]);
+            test_rtt_write(TEST_RECORD_CONTROL, pair, (unsigned)len);
+            first = false;
+        }
+    }
+
+    test_rtt_write(TEST_RECORD_CONTROL, "\r\n", 2);
+}
+
+void test_metrics_snapshot(const char* scope) {
+    if (metric_count == 0) {
+        return;
+    }
+
+    test_rtt_printf(TEST_RECORD_CONTROL, "METRICS:%s:%" PRIu32 ":%" PRIu32 "\r\n", scope, metric_count, metrics_dropped);
+
+    for (uint32_t i = 0; i < metric_count; i++) {
+        const test_metric_t* metric = metrics[i];
+
+        switch (metric->type) {
+            case TEST_METRIC_COUNTER: {
+                const test_counter_t* counter = (const test_counter_t*)metric;
+                test_rtt_printf(TEST_RECORD_CONTROL, "METRIC:C:%s:%" PRIu32 "\r\n", metric->name, counter->value);
+                break;
+            }
+            case TEST_METRIC_GAUGE: {
+                const test_gauge_t* gauge = (const test_gauge_t*)metric;
+                /* min/max would still be the INT32_MAX/INT32_MIN sentinels */
+                if (!gauge->set) {
+                    break;
+                }
+                test_rtt_printf(TEST_RECORD_CONTROL, "METRIC:G:%s:%" PRId32 ":%" PRId32 ":%" PRId32 "\r\n",
+                               metric->name, gauge->value, gauge->min, gauge->max);
+                break;
+            }
+            case TEST_METRIC_HISTOGRAM:
+                snapshot_histogram((const test_histogram_t*)metric);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void test_metrics_reset(void) {
+    for (uint32_t i = 0; i < metric_count; i++) {
+        test_metric_t* metric = metrics[i];
+
+        switch (metric->type) {
+            case TEST_METRIC_COUNTER:
+                ((test_counter_t*)metric)->value = 0;
+                break;
+            case TEST_METRIC_GAUGE: {
+                test_gauge_t* gauge = (test_gauge_t*)metric;
+                gauge->value = 0;
+                gauge->min = INT32_MAX;
+                gauge->max = INT32_MIN;
+                gauge->set = false;
+                break;
+            }
+            case TEST_METRIC_HISTOGRAM: {
+                test_histogram_t* hist = (test_histogram_t*)metric;
+                hist->count = 0;
+                hist->sum = 0;
+                hist->min = UINT32_MAX;
+                hist->max = 0;
+                memset(hist->buckets, 0, sizeof(hist->buckets));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
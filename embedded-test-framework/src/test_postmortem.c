@@ -0,0 +1,196 @@
+#include "test_postmortem.h"
+#include "test_rtt_logger.h"
+#include <stddef.h>
+#include <string.h>
+
+#if TEST_POSTMORTEM_ENABLED
+
+#if (TEST_POSTMORTEM_SIZE & (TEST_POSTMORTEM_SIZE - 1u)) != 0
+#error "TEST_POSTMORTEM_SIZE must be a power of two"
+#endif
+
+#if TEST_HOST_BUILD
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t boot;          /* sessions since the last cold start */
+    uint32_t head;          /* bytes ever written; data holds the last size of them */
+    uint32_t complete;      /* test_summary() finished */
+    uint32_t crc;           /* CRC-32 of the fields above */
+} pm_header_t;
+
+typedef struct {
+    pm_header_t header;
+    char data[TEST_POSTMORTEM_SIZE];
+} pm_ring_t;
+
+static pm_ring_t pm_noinit __attribute__((section(".noinit")));
+static pm_ring_t* pm_ring = &pm_noinit;
+
+/* Off until init has dealt with the previous session */
+static bool pm_recording = false;
+
+/* Nibble-wise CRC-32 (IEEE, reflected): a 64-byte table for a 20-byte header */
+static uint32_t pm_crc32(const void* data, unsigned length) {
+    static const uint32_t table[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu,
+        0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+        0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+    };
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (unsigned i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ table[crc & 0x0Fu];
+        crc = (crc >> 4) ^ table[crc & 0x0Fu];
+    }
+    return ~crc;
+}
+
+static uint32_t pm_header_crc(const pm_header_t* header) {
+    return pm_crc32(header, (unsigned)offsetof(pm_header_t, crc));
+}
+
+/* The CRC is worked out on a copy, so the ring only goes stale between two stores */
+static void pm_update(uint32_t head, uint32_t complete) {
+    pm_header_t header = pm_ring->header;
+
+    header.head = head;
+    header.complete = complete;
+    header.crc = pm_header_crc(&header);
+
+    pm_ring->header.head = head;
+    pm_ring->header.complete = complete;
+    pm_ring->header.crc = header.crc;
+}
+
+#if TEST_HOST_BUILD
+/* A file stands in for RAM that survives the reset; without one every run is a cold start */
+static void pm_map_host_file(void) {
+    const char* path = getenv("TEST_NOINIT_FILE");
+    if (path == NULL) {
+        return;
+    }
+
+    const int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return;
+    }
+    if (ftruncate(fd, sizeof(pm_ring_t)) == 0) {
+        void* mapped = mmap(NULL, sizeof(pm_ring_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            pm_ring = (pm_ring_t*)mapped;
+        }
+    }
+    close(fd);
+}
+#endif
+
+static void pm_send_line(const char* text, unsigned length) {
+    char line[TEST_WRITE_LINE_MAX];
+    const unsigned room = (unsigned)sizeof(line) - 5u;     /* "PM:" and CRLF */
+
+    if (length > room) {
+        length = room;
+    }
+    memcpy(line, "PM:", 3);
+    memcpy(line + 3, text, length);
+    line[3 + length] = '\r';
+    line[4 + length] = '\n';
+    test_rtt_write(TEST_RECORD_CONTROL, line, length + 5u);
+}
+
+/* Sends the retained lines oldest first; a line cut by the wrap is left out */
+static uint32_t pm_dump(uint32_t head) {
+    const uint32_t kept = head < TEST_POSTMORTEM_SIZE ? head : TEST_POSTMORTEM_SIZE;
+    uint32_t position = head - kept;
+    char text[TEST_WRITE_LINE_MAX];
+    unsigned length = 0;
+    uint32_t lines = 0;
+    bool skipping = position > 0;
+
+    for (; position != head; position++) {
+        const char c = pm_ring->data[position & (TEST_POSTMORTEM_SIZE - 1u)];
+
+        if (c == '\n') {
+            if (!skipping) {
+                pm_send_line(text, length);
+                lines++;
+            }
+            skipping = false;
+            length = 0;
+        } else if (!skipping && c != '\r' && length < sizeof(text)) {
+            text[length++] = c;
+        }
+    }
+    /* The last line never got its CRLF: the reset came while it was written */
+    if (!skipping && length > 0) {
+        pm_send_line(text, length);
+        lines++;
+    }
+    return lines;
+}
+
+void test_postmortem_init(void) {
+#if TEST_HOST_BUILD
+    pm_map_host_file();
+#endif
+    pm_header_t* header = &pm_ring->header;
+    uint32_t boot = 1;
+
+    if (header->magic != TEST_POSTMORTEM_MAGIC || header->size != TEST_POSTMORTEM_SIZE) {
+        test_rtt_printf(TEST_RECORD_CONTROL, "POSTMORTEM:COLD\r\n");
+    } else if (header->crc != pm_header_crc(header)) {
+        /* Reset between the stores in pm_update(), or RAM that did not hold */
+        test_rtt_printf(TEST_RECORD_CONTROL, "POSTMORTEM:CORRUPT\r\n");
+    } else if (header->complete) {
+        test_rtt_printf(TEST_RECORD_CONTROL, "POSTMORTEM:CLEAN:%" PRIu32 "\r\n", header->boot);
+        boot = header->boot + 1u;
+    } else {
+        const uint32_t head = header->head;
+        const uint32_t kept = head < TEST_POSTMORTEM_SIZE ? head : TEST_POSTMORTEM_SIZE;
+
+        test_rtt_printf(TEST_RECORD_CONTROL, "POSTMORTEM:BEGIN:%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                        header->boot, kept, head - kept);
+        const uint32_t lines = pm_dump(head);
+        test_rtt_printf(TEST_RECORD_CONTROL, "POSTMORTEM:END:%" PRIu32 "\r\n", lines);
+        boot = header->boot + 1u;
+    }
+
+    header->magic = TEST_POSTMORTEM_MAGIC;
+    header->size = TEST_POSTMORTEM_SIZE;
+    header->boot = boot;
+    pm_update(0, 0);
+    pm_recording = true;
+}
+
+void test_postmortem_record(const char* data, unsigned length) {
+    if (!pm_recording) {
+        return;
+    }
+
+    uint32_t head = pm_ring->header.head;
+    for (unsigned i = 0; i < length; i++, head++) {
+        pm_ring->data[head & (TEST_POSTMORTEM_SIZE - 1u)] = data[i];
+    }
+    /* Data first: a reset before the header update leaves the previous one valid */
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    pm_update(head, pm_ring->header.complete);
+}
+
+void test_postmortem_complete(void) {
+    if (!pm_recording) {
+        return;
+    }
+    pm_update(pm_ring->header.head, 1);
+}
+
+#endif
@@ -0,0 +1,240 @@
+#include "test_profiler.h"
+#include "test_rtt_logger.h"
+#include "test_flow.h"
+#include <string.h>
+
+#if TEST_PROFILER_ENABLED
+
+#if TEST_HOST_BUILD
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+
+typedef struct {
+    uint32_t pc;
+    uint32_t lr;
+    uint32_t count;
+} profile_record_t;
+
+static char profile_buffer[RTT_BUFFER_PROFILE_SIZE];
+static profile_record_t profile_slots[TEST_PROFILER_SLOTS];
+static volatile uint32_t samples_taken = 0;
+static volatile uint32_t samples_dropped = 0;
+
+#if TEST_PROFILER_MODE == TEST_PROFILER_MODE_HISTOGRAM
+#define PROFILER_MAX_PROBES 8
+static volatile bool sampling_paused = false;
+#else
+static volatile uint32_t ring_head = 0;     /* written by the sampling interrupt */
+static volatile uint32_t ring_tail = 0;     /* written by test_profiler_drain() */
+#endif
+
+void test_profiler_init(void) {
+    SEGGER_RTT_ConfigUpBuffer(RTT_CHANNEL_PROFILE, "Profile", profile_buffer,
+                              sizeof(profile_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    test_flow_register(RTT_CHANNEL_PROFILE, sizeof(profile_buffer));
+}
+
+void test_profiler_record(uint32_t pc, uint32_t lr) {
+    samples_taken++;
+
+#if TEST_PROFILER_MODE == TEST_PROFILER_MODE_HISTOGRAM
+    if (sampling_paused) {
+        samples_dropped++;
+        return;
+    }
+
+    uint32_t slot = ((pc ^ (lr * 31u)) * 2654435761u) & (TEST_PROFILER_SLOTS - 1);
+    for (uint32_t probe = 0; probe < PROFILER_MAX_PROBES; probe++) {
+        profile_record_t* entry = &profile_slots[slot];
+
+        if (entry->count != 0 && entry->pc == pc && entry->lr == lr) {
+            entry->count++;
+            return;
+        }
+        if (entry->count == 0) {
+            entry->pc = pc;
+            entry->lr = lr;
+            entry->count = 1;
+            return;
+        }
+        slot = (slot + 1) & (TEST_PROFILER_SLOTS - 1);
+    }
+    samples_dropped++;
+#else
+    if (ring_head - ring_tail >= TEST_PROFILER_SLOTS) {
+        samples_dropped++;
+        return;
+    }
+
+    profile_record_t* entry = &profile_slots[ring_head & (TEST_PROFILER_SLOTS - 1)];
+    entry->pc = pc;
+    entry->lr = lr;
+    entry->count = 1;
+    ring_head++;
+#endif
+}
+
+void test_profiler_sample(const uint32_t* exception_frame) {
+    /* Basic frame: r0-r3, r12, lr, pc, xpsr */
+    test_profiler_record(exception_frame[6], TEST_PROFILER_CAPTURE_LR ? exception_frame[5] : 0u);
+}
+
+void test_profiler_drain(void) {
+#if TEST_PROFILER_MODE == TEST_PROFILER_MODE_HISTOGRAM
+    sampling_paused = true;
+    for (uint32_t i = 0; i < TEST_PROFILER_SLOTS; i++) {
+        profile_record_t* entry = &profile_slots[i];
+
+        if (entry->count == 0) {
+            continue;
+        }
+        /* Slots that do not fit stay in RAM for the next drain */
+        if (test_flow_write(RTT_CHANNEL_PROFILE, entry, sizeof(*entry)) != sizeof(*entry)) {
+            break;
+        }
+        entry->count = 0;
+    }
+    sampling_paused = false;
+#else
+    while (ring_tail != ring_head) {
+        const profile_record_t* entry = &profile_slots[ring_tail & (TEST_PROFILER_SLOTS - 1)];
+
+        if (test_flow_write(RTT_CHANNEL_PROFILE, entry, sizeof(*entry)) != sizeof(*entry)) {
+            break;
+        }
+        ring_tail++;
+    }
+#endif
+
+    test_rtt_printf(TEST_RECORD_CONTROL, "PROFILE:%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                   (uint32_t)samples_taken, (uint32_t)samples_dropped, (uint32_t)TEST_PROFILER_RATE_HZ);
+}
+
+#if TEST_HOST_BUILD
+
+static void profiler_sigprof(int signal_number, siginfo_t* info, void* context) {
+    const ucontext_t* uc = (const ucontext_t*)context;
+    uint64_t pc = 0;
+    uint64_t lr = 0;
+
+    (void)signal_number;
+    (void)info;
+
+#if defined(__x86_64__)
+    pc = (uint64_t)uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+    pc = uc->uc_mcontext.pc;
+    lr = TEST_PROFILER_CAPTURE_LR ? uc->uc_mcontext.regs[30] : 0;
+#endif
+
+    /* Shared libraries live above 4 GiB; lump them together */
+    test_profiler_record(pc > UINT32_MAX ? UINT32_MAX : (uint32_t)pc,
+                         lr > UINT32_MAX ? UINT32_MAX : (uint32_t)lr);
+}
+
+void test_profiler_start(void) {
+    struct sigaction action;
+    struct itimerval timer;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = profiler_sigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / TEST_PROFILER_RATE_HZ;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+void test_profiler_stop(void) {
+    struct itimerval timer;
+
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+#else
+
+#define SYST_CSR  (*(volatile uint32_t*)0xE000E010u)
+#define SYST_RVR  (*(volatile uint32_t*)0xE000E014u)
+#define SYST_CVR  (*(volatile uint32_t*)0xE000E018u)
+
+#if TEST_PROFILER_USE_SYSTICK
+
+#if TEST_PROFILER_RATE_HZ % 1000u != 0
+#error "TEST_PROFILER_RATE_HZ must be a multiple of 1000 to keep the 1 ms HAL tick"
+#endif
+
+/* The HAL's tick (HAL_GetTick, HAL_Delay) counts SysTick; absent without the HAL */
+extern void HAL_IncTick(void) __attribute__((weak));
+
+void test_profiler_systick(const uint32_t* exception_frame);
+
+static volatile uint32_t systick_per_ms = 1;     /* SysTick periods per HAL tick */
+static volatile bool systick_sampling = false;
+static uint32_t saved_rvr;
+static uint32_t saved_csr;
+
+void test_profiler_start(void) {
+    saved_rvr = SYST_RVR;
+    saved_csr = SYST_CSR & 0x7u;
+    systick_per_ms = TEST_PROFILER_RATE_HZ / 1000u;
+    systick_sampling = true;
+    SYST_RVR = TEST_CPU_HZ / TEST_PROFILER_RATE_HZ - 1u;
+    SYST_CVR = 0;
+    SYST_CSR = 0x7u;    /* processor clock, interrupt, enable */
+}
+
+/* Back to the application's SysTick setup, normally the HAL's 1 kHz tick */
+void test_profiler_stop(void) {
+    SYST_CSR = 0;
+    systick_sampling = false;
+    systick_per_ms = 1;
+    SYST_RVR = saved_rvr;
+    SYST_CVR = 0;
+    SYST_CSR = saved_csr;
+}
+
+/* Samples while profiling, and keeps HAL_IncTick() at 1 kHz either way */
+void test_profiler_systick(const uint32_t* exception_frame) {
+    static uint32_t ticks = 0;
+
+    if (systick_sampling) {
+        test_profiler_sample(exception_frame);
+    }
+    if (++ticks >= systick_per_ms) {
+        ticks = 0;
+        if (HAL_IncTick != NULL) {
+            HAL_IncTick();
+        }
+    }
+}
+
+/* Hand the stacked exception frame (MSP or PSP, per EXC_RETURN) to the sampler */
+__attribute__((naked)) void SysTick_Handler(void) {
+    __asm volatile(
+        "tst lr, #4             \n"
+        "ite eq                 \n"
+        "mrseq r0, msp          \n"
+        "mrsne r0, psp          \n"
+        "b test_profiler_systick\n"
+    );
+}
+
+#else
+
+void test_profiler_start(void) {
+}
+
+void test_profiler_stop(void) {
+}
+
+#endif
+
+#endif
+
+#endif
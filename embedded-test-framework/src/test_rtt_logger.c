@@ -1,8 +1,23 @@
 #include "test_rtt_logger.h"
-#include <stdio.h>
+#include "test_metrics.h"
+#include "test_trace.h"
+#include "test_func_trace.h"
+#include "test_profiler.h"
+#include "test_coverage.h"
+#include "test_flow.h"
+#include "test_bulk.h"
+#include "test_logz.h"
+#include "test_postmortem.h"
+#include "test_fault.h"
 #include <stdarg.h>
 #include <string.h>
 
+#if TEST_LOG_DEFERRED && TEST_HOST_BUILD
+#include <stdlib.h>
+
+static void log_drain_at_exit(void);
+#endif
+
 static const char* log_level_strings[] = {
     "ERROR", "WARN", "INFO", "DEBUG"
 };
@@ -10,73 +25,1161 @@ static const char* log_level_strings[] = {
 static uint32_t test_counter = 0;
 static uint32_t passed_tests = 0;
 static uint32_t failed_tests = 0;
+static uint32_t test_start_cycles = 0;
+static const char* running_test = NULL;
+static uint32_t sync_sequence = 0;
+static uint32_t last_sync_cycles = 0;
+
+#if TEST_SOAK_MODE
+typedef struct {
+    const char* name;
+    uint32_t runs;
+    uint32_t passed;
+    uint32_t failed;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint32_t hist[TEST_SOAK_HIST_BUCKETS];  /* bucket n: [2^n, 2^(n+1)) cycles */
+} soak_entry_t;
+
+static soak_entry_t soak_entries[TEST_SOAK_MAX_TESTS];
+static uint32_t soak_entry_count = 0;
+static uint32_t soak_overflow_tests = 0;
+static uint32_t soak_log_counts[4];
+static uint32_t soak_iterations = 0;
+static uint64_t soak_elapsed_cycles = 0;
+
+static soak_entry_t* soak_find_entry(const char* test_name) {
+    for (uint32_t i = 0; i < soak_entry_count; i++) {
+        if (soak_entries[i].name == test_name || strcmp(soak_entries[i].name, test_name) == 0) {
+            return &soak_entries[i];
+        }
+    }
+    
+    if (soak_entry_count >= TEST_SOAK_MAX_TESTS) {
+        return NULL;
+    }
+    
+    soak_entry_t* entry = &soak_entries[soak_entry_count++];
+    entry->name = test_name;
+    entry->min_cycles = UINT32_MAX;
+    return entry;
+}
+
+static void soak_record_result(const char* test_name, bool passed, uint32_t duration_cycles) {
+    soak_entry_t* entry = soak_find_entry(test_name);
+    if (entry == NULL) {
+        soak_overflow_tests++;
+        return;
+    }
+    
+    entry->runs++;
+    if (passed) {
+        entry->passed++;
+    } else {
+        entry->failed++;
+    }
+    if (duration_cycles < entry->min_cycles) {
+        entry->min_cycles = duration_cycles;
+    }
+    if (duration_cycles > entry->max_cycles) {
+        entry->max_cycles = duration_cycles;
+    }
+    entry->hist[31 - __builtin_clz(duration_cycles | 1u)]++;
+}
+#endif
+
+#if TEST_OCCUPANCY_ENABLED
+typedef struct {
+    uint32_t writes;
+    uint32_t dropped;
+    uint32_t high_water;
+    uint32_t near_full_cycles;
+    uint32_t last_cycles;
+    bool near_full;
+    uint32_t buckets[TEST_OCCUPANCY_BUCKETS + 1];   /* last bucket: did not fit */
+} occupancy_t;
+
+static occupancy_t occupancy;
+
+static void occupancy_record(uint32_t fill_before, unsigned length, bool complete) {
+    const uint32_t size = _SEGGER_RTT.aUp[0].SizeOfBuffer;
+    const uint32_t now = test_get_cycles();
+    /* Demand, not what was stored: trimmed and dropped lines land past the end */
+    const uint32_t demand = fill_before + length;
+    
+    occupancy.writes++;
+    if (!complete) {
+        occupancy.dropped++;
+    }
+    if (demand > occupancy.high_water) {
+        occupancy.high_water = demand;
+    }
+    
+    /* Near-full time runs from a near-full write to the next write */
+    if (occupancy.near_full) {
+        occupancy.near_full_cycles += now - occupancy.last_cycles;
+    }
+    occupancy.near_full = demand * 100u >= size * TEST_OCCUPANCY_NEAR_FULL_PCT;
+    occupancy.last_cycles = now;
+    
+    occupancy.buckets[demand >= size ? TEST_OCCUPANCY_BUCKETS : demand * TEST_OCCUPANCY_BUCKETS / size]++;
+}
+
+static void occupancy_report(const char* test_name) {
+    char hist[(TEST_OCCUPANCY_BUCKETS + 1) * 14];
+    int len = 0;
+    
+    if (occupancy.near_full) {
+        occupancy.near_full_cycles += test_get_cycles() - occupancy.last_cycles;
+    }
+    
+    for (uint32_t b = 0; b <= TEST_OCCUPANCY_BUCKETS; b++) {
+        if (occupancy.buckets[b] != 0) {
+            len += test_format(hist + len, sizeof(hist) - len, "%s%" PRIu32 "=%" PRIu32,
+                            len > 0 ? "," : "", b, occupancy.buckets[b]);
+        }
+    }
+    hist[len] = '\0';
+    
+    test_rtt_printf(TEST_RECORD_CONTROL, "RTTOCC:%s:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%s\r\n",
+                    test_name, (uint32_t)_SEGGER_RTT.aUp[0].SizeOfBuffer,
+                    occupancy.writes, occupancy.dropped, occupancy.high_water,
+                    occupancy.near_full_cycles, hist);
+}
+#endif
+
+typedef struct {
+    uint32_t written;
+    uint32_t trimmed;
+    uint32_t dropped;
+    uint32_t timeouts;
+    uint32_t blocked_cycles;
+    uint32_t max_block_cycles;
+} write_stats_t;
+
+static const char* record_class_strings[TEST_RECORD_CLASSES] = {
+    "ERROR", "WARN", "INFO", "DEBUG", "CONTROL"
+};
+
+static test_write_policy_t write_policy = TEST_WRITE_POLICY_DEFAULT;
+static write_stats_t write_stats[TEST_RECORD_CLASSES];
+static bool write_stalled = false;
+/* All classes; test_result() takes a test's share out of its duration */
+static uint32_t write_blocked_cycles = 0;
+static uint32_t test_start_blocked = 0;
+
+/* Shortest cut line worth sending: a few bytes of text plus the marker */
+#define WRITE_TRIM_MARKER     "...\r\n"
+#define WRITE_TRIM_MIN        16u
+
+/*
+ * Spin until length bytes fit in channel 0 or the block timeout expires.
+ * After a timeout the host is taken to be gone: later writes do not spin
+ * again until space shows up, so a detached probe costs one timeout, not one
+ * per line.
+ */
+static bool write_wait_for_space(write_stats_t* stats, unsigned length) {
+    if (SEGGER_RTT_GetAvailWriteSpace(0) >= length) {
+        write_stalled = false;
+        return true;
+    }
+    if (write_stalled) {
+        return false;
+    }
+    
+    const uint32_t timeout = write_policy.block_timeout_ms * (TEST_CPU_HZ / 1000u);
+    const uint32_t start = test_get_cycles();
+    uint32_t waited = 0;
+    bool fits = false;
+    
+    while (!fits && waited < timeout) {
+        fits = SEGGER_RTT_GetAvailWriteSpace(0) >= length;
+        waited = test_get_cycles() - start;
+    }
+    
+    stats->blocked_cycles += waited;
+    write_blocked_cycles += waited;
+    if (waited > stats->max_block_cycles) {
+        stats->max_block_cycles = waited;
+    }
+    if (!fits) {
+        stats->timeouts++;
+        write_stalled = true;
+    }
+    return fits;
+}
+
+static int write_trimmed(const char* data, unsigned length) {
+    const unsigned marker = sizeof(WRITE_TRIM_MARKER) - 1u;
+    const unsigned avail = SEGGER_RTT_GetAvailWriteSpace(0);
+    
+    if (avail < WRITE_TRIM_MIN || avail < marker + 1u) {
+        return -1;
+    }
+    
+    const unsigned head = (avail - marker < length) ? avail - marker : length;
+    SEGGER_RTT_Write(0, data, head);
+    SEGGER_RTT_Write(0, WRITE_TRIM_MARKER, marker);
+    return (int)(head + marker);
+}
+
+/* All channel 0 lines go through here; returns the bytes stored or -1 */
+int test_rtt_write(int record_class, const char* data, unsigned length) {
+    write_stats_t* stats = &write_stats[record_class];
+    const uint8_t policy = write_policy.policy[record_class];
+#if TEST_OCCUPANCY_ENABLED
+    const uint32_t fill_before = SEGGER_RTT_GetBytesInBuffer(0);
+#endif
+    int result = -1;
+    
+#if TEST_POSTMORTEM_ENABLED
+    /* Kept whether or not the channel takes it: those are the lines a reset loses */
+    test_postmortem_record(data, length);
+#endif
+    
+    if (policy == TEST_WRITE_BLOCK) {
+        write_wait_for_space(stats, length);
+    }
+    
+    if (SEGGER_RTT_GetAvailWriteSpace(0) >= length) {
+        if (SEGGER_RTT_Write(0, data, length) == length) {
+            result = (int)length;
+        }
+    } else if (policy == TEST_WRITE_TRIM) {
+        result = write_trimmed(data, length);
+        if (result >= 0) {
+            stats->trimmed++;
+        }
+    }
+    
+    if (result < 0) {
+        stats->dropped++;
+    } else {
+        stats->written++;
+    }
+    
+#if TEST_OCCUPANCY_ENABLED
+    occupancy_record(fill_before, length, result == (int)length);
+#endif
+    return result;
+}
+
+/* Over-long lines are cut but still end in CRLF */
+static unsigned line_length(char* line, size_t size, int length) {
+    if ((size_t)length >= size) {
+        length = (int)size - 1;
+        line[length - 2] = '\r';
+        line[length - 1] = '\n';
+    }
+    return (unsigned)length;
+}
+
+int test_rtt_printf(int record_class, const char* format, ...) {
+    char line[TEST_WRITE_LINE_MAX];
+    va_list args;
+    int length;
+    
+    va_start(args, format);
+    length = test_vformat(line, sizeof(line), format, args);
+    va_end(args);
+    
+    return test_rtt_write(record_class, line, line_length(line, sizeof(line), length));
+}
+
+static void write_stats_report(void) {
+    for (int c = 0; c < TEST_RECORD_CLASSES; c++) {
+        const write_stats_t* stats = &write_stats[c];
+        
+        if (stats->written == 0 && stats->dropped == 0) {
+            continue;
+        }
+        test_rtt_printf(TEST_RECORD_CONTROL, "WRITESTATS:%s:%u:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                        record_class_strings[c], (unsigned)write_policy.policy[c],
+                        stats->written, stats->trimmed, stats->dropped, stats->timeouts,
+                        stats->blocked_cycles, stats->max_block_cycles);
+    }
+}
+
+static void cycle_counter_init(void) {
+#if !TEST_HOST_BUILD
+    TEST_DEMCR |= (1u << 24);      /* TRCENA */
+    TEST_DWT_CYCCNT = 0;
+    TEST_DWT_CTRL |= 1u;           /* CYCCNTENA */
+#endif
+}
+
+void test_rtt_init_with_policy(const test_write_policy_t* policy) {
+    write_policy = *policy;
+    test_rtt_init();
+}
 
 void test_rtt_init(void) {
     SEGGER_RTT_Init();
     SEGGER_RTT_ConfigUpBuffer(0, NULL, NULL, RTT_BUFFER_UP_SIZE, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    cycle_counter_init();
+#if TEST_POSTMORTEM_ENABLED
+    /* Before any other line, which would overwrite the previous session */
+    test_postmortem_init();
+#endif
+#if TEST_FAULT_ENABLED
+    test_fault_init();
+#endif
+#if TEST_FLOW_ENABLED
+    test_flow_init();
+#endif
+#if TEST_TRACE_ENABLED
+    test_trace_init();
+#endif
+#if TEST_FUNC_TRACE_ENABLED
+    test_func_trace_init();
+#endif
+#if TEST_PROFILER_ENABLED
+    test_profiler_init();
+#endif
+#if TEST_COVERAGE_ENABLED
+    test_coverage_init();
+#endif
+#if TEST_BULK_ENABLED
+    test_bulk_init();
+#endif
+#if TEST_LOG_COMPRESS
+    test_logz_init();
+#endif
+    test_clock_sync();
+#if TEST_LOG_DEFERRED && TEST_HOST_BUILD
+    atexit(log_drain_at_exit);
+#endif
     
     TEST_LOG_INFO("=== RTT Test Framework Initialized ===");
     TEST_LOG_INFO("RTT Buffer Size: %d bytes", RTT_BUFFER_UP_SIZE);
     
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:REPEAT:%u\r\n", (unsigned)TEST_REPEAT_COUNT);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:CPU_HZ:%u\r\n", (unsigned)TEST_CPU_HZ);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:SOAK:%u\r\n", (unsigned)TEST_SOAK_MODE);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:TRACE:%u\r\n", (unsigned)TEST_TRACE_ENABLED);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:FUNC_TRACE:%u\r\n", (unsigned)TEST_FUNC_TRACE_ENABLED);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:PROFILE:%u\r\n", (unsigned)TEST_PROFILER_ENABLED);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:COVERAGE:%u\r\n", (unsigned)TEST_COVERAGE_ENABLED);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:OCCUPANCY:%u\r\n", (unsigned)TEST_OCCUPANCY_ENABLED);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:FLOW:%u\r\n", (unsigned)TEST_FLOW_ENABLED);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:BULK:%u\r\n", (unsigned)TEST_BULK_ENABLED);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:COMPRESS:%u\r\n", (unsigned)TEST_LOG_COMPRESS);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:POSTMORTEM:%u\r\n", (unsigned)TEST_POSTMORTEM_ENABLED);
+    test_rtt_printf(TEST_RECORD_CONTROL, "CONFIG:FAULT:%u\r\n", (unsigned)TEST_FAULT_ENABLED);
     test_status(TEST_STATUS_INIT, "Test Framework");
+#if TEST_PROFILER_ENABLED
+    test_profiler_start();
+#endif
+}
+
+void test_clock_sync(void) {
+    last_sync_cycles = test_get_cycles();
+    test_rtt_printf(TEST_RECORD_CONTROL, "SYNC:%" PRIu32 ":%" PRIu32 "\r\n", ++sync_sequence, last_sync_cycles);
+}
+
+static void clock_sync_if_due(void) {
+    if (test_get_cycles() - last_sync_cycles >= TEST_SYNC_INTERVAL_MS * (TEST_CPU_HZ / 1000u)) {
+        test_clock_sync();
+    }
+}
+
+static const char* log_site_file(const test_log_site_t* site) {
+    const char* name = site->file;
+    for (const char* p = site->file; *p != '\0'; p++) {
+        if (*p == '/' || *p == '\\') {
+            name = p + 1;
+        }
+    }
+    return name;
+}
+
+static test_log_sampler_t* log_samplers = NULL;
+
+#if TEST_LOG_SAMPLE_RANDOM
+uint32_t test_log_sample_state = 0x9E3779B9u;
+#endif
+
+/* Called once per sampler, on its first call */
+void test_log_sampler_register(test_log_sampler_t* sampler) {
+    sampler->next = log_samplers;
+    log_samplers = sampler;
+}
+
+/* "[1/n file:line] " ahead of a sampled message; empty for ordinary lines */
+static int log_sample_tag(char* out, size_t size, const test_log_sampler_t* sampler) {
+    if (sampler == NULL) {
+        out[0] = '\0';
+        return 0;
+    }
+    return test_format(out, size, "[1/%" PRIu32 " %s:%" PRIu32 "] ",
+                       sampler->rate, log_site_file(&sampler->site), sampler->site.line);
+}
+
+/* LOGSAMPLE:file:line:rate:calls:emitted for every sampled site that was reached */
+static void log_sample_report(void) {
+    for (const test_log_sampler_t* sampler = log_samplers; sampler != NULL; sampler = sampler->next) {
+        test_rtt_printf(TEST_RECORD_CONTROL, "LOGSAMPLE:%s:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                        log_site_file(&sampler->site), sampler->site.line,
+                        sampler->rate, sampler->calls, sampler->emitted);
+    }
+}
+
+#if TEST_LOG_RATE_LIMIT > 0
+#define LOG_TOKEN_CYCLES (TEST_CPU_HZ / TEST_LOG_RATE_LIMIT)
+
+static test_log_site_t* log_limited_sites = NULL;
+static uint32_t log_rate_limited = 0;
+static uint64_t log_clock = 0;
+static uint32_t log_clock_last = 0;
+
+/* The cycle counter extended to 64 bits; exact while some site logs once per wrap */
+static uint64_t log_clock_now(void) {
+    const uint32_t now = test_get_cycles();
+    
+    log_clock += now - log_clock_last;
+    log_clock_last = now;
+    return log_clock;
+}
+
+/* Token bucket in cycles: refills with elapsed time, a line takes LOG_TOKEN_CYCLES */
+static bool log_site_allow(test_log_site_t* site) {
+    const uint32_t capacity = LOG_TOKEN_CYCLES * TEST_LOG_RATE_BURST;
+    const uint64_t now = log_clock_now();
+    
+    if (!site->primed) {
+        site->primed = true;
+        site->tokens = capacity;
+    } else {
+        const uint64_t elapsed = now - site->last_cycles;
+        site->tokens = elapsed >= capacity - site->tokens ? capacity : site->tokens + (uint32_t)elapsed;
+    }
+    site->last_cycles = now;
+    
+    if (site->tokens >= LOG_TOKEN_CYCLES) {
+        site->tokens -= LOG_TOKEN_CYCLES;
+        return true;
+    }
+    
+    site->suppressed++;
+    site->total_suppressed++;
+    log_rate_limited++;
+    if (!site->listed) {
+        site->listed = true;
+        site->next = log_limited_sites;
+        log_limited_sites = site;
+    }
+    return false;
+}
+
+/* LOGLIMIT:file:line:suppressed for each site that dropped lines since the last report */
+static void log_limit_report(void) {
+    for (test_log_site_t* site = log_limited_sites; site != NULL; site = site->next) {
+        if (site->suppressed > 0) {
+            test_rtt_printf(TEST_RECORD_CONTROL, "LOGLIMIT:%s:%" PRIu32 ":%" PRIu32 "\r\n",
+                            log_site_file(site), site->line, site->suppressed);
+            site->suppressed = 0;
+        }
+    }
+}
+#endif
+
+#if TEST_LOG_REPEAT_SUPPRESS
+static int repeat_level = -1;
+static uint32_t repeat_hash = 0;
+static size_t repeat_length = 0;
+static char repeat_text[TEST_LOG_REPEAT_COMPARE];
+static uint32_t repeat_count = 0;
+static uint32_t log_repeats = 0;
+
+static uint32_t log_hash(const char* text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/* Writes the pending repeat count and forgets the last line; called before other records */
+static void log_repeat_flush(void) {
+    if (repeat_count > 0) {
+        test_rtt_printf(repeat_level, "[%08" PRIu32 "] [%s] last message repeated %" PRIu32 " times\r\n",
+                        test_get_cycles(), log_level_strings[repeat_level], repeat_count);
+        repeat_count = 0;
+    }
+    repeat_level = -1;
+}
+
+/* True if the line repeats the previous one and was only counted. The hash covers
+ * the whole line, the stored copy its start, so a collision alone cannot drop it */
+static bool log_repeat_check(int level, const char* text, size_t length) {
+    const uint32_t hash = log_hash(text, length);
+    const size_t compare = length < sizeof(repeat_text) ? length : sizeof(repeat_text);
+    
+    if (level == repeat_level && hash == repeat_hash && length == repeat_length &&
+        memcmp(text, repeat_text, compare) == 0) {
+        repeat_count++;
+        log_repeats++;
+        return true;
+    }
+    log_repeat_flush();
+    repeat_level = level;
+    repeat_hash = hash;
+    repeat_length = length;
+    memcpy(repeat_text, text, compare);
+    return false;
+}
+#endif
+
+/* Message for log_line(): C varargs, or a record serialized by test_log.hpp */
+typedef struct {
+    const char* format;
+    va_list* list;
+    const test_format_arg_t* args;
+    size_t count;
+    const test_log_sampler_t* sampler;
+} log_message_t;
+
+static int log_message_format(char* out, size_t size, const log_message_t* message) {
+    if (message->list == NULL) {
+        return test_format_args(out, size, message->format, message->args, message->count);
+    }
+    
+    va_list args;
+    int length;
+    
+    va_copy(args, *message->list);
+    length = test_vformat(out, size, message->format, args);
+    va_end(args);
+    return length;
+}
+
+/* log_emit() cost argument: time the formatting there, nothing was queued */
+#define LOG_COST_MEASURE UINT32_MAX
+
+#if TEST_LOG_COMPRESS
+/* True once the line went out on the compressed channel or was counted as a repeat */
+static bool log_emit_compressed(int level, uint32_t timestamp, uint32_t cost, const log_message_t* message) {
+    test_format_arg_t captured[TEST_LOG_MAX_ARGS];
+    const test_format_arg_t* args = message->args;
+    size_t count = message->count;
+    test_logz_record_t record;
+    
+    /* The "[1/n file:line]" tag only exists as text */
+    if (message->sampler != NULL) {
+        return false;
+    }
+    
+    if (message->list != NULL) {
+        count = test_format_capture(message->format, *message->list, captured, TEST_LOG_MAX_ARGS);
+        args = captured;
+    }
+    if (!test_logz_encode(&record, message->format, args, count)) {
+        return false;
+    }
+    
+#if TEST_LOG_REPEAT_SUPPRESS
+    /* The body holds the format slot and every argument, strings included */
+    if (log_repeat_check(level, (const char*)record.data + TEST_LOGZ_HEADER_MAX,
+                         record.used - TEST_LOGZ_HEADER_MAX)) {
+        return true;
+    }
+#endif
+    
+    if (cost == LOG_COST_MEASURE) {
+        cost = test_get_cycles() - timestamp;
+    }
+    return test_logz_send(&record, level, timestamp, cost);
+}
+#endif
+
+/* Formats and writes one line stamped with timestamp */
+static void log_emit(int level, uint32_t timestamp, uint32_t cost, const log_message_t* message) {
+    char line[TEST_WRITE_LINE_MAX];
+    size_t used;
+    
+    TRACE_BEGIN("test_log");
+    
+#if TEST_LOG_COMPRESS
+    if (log_emit_compressed(level, timestamp, cost, message)) {
+        TRACE_END("test_log");
+        return;
+    }
+#endif
+    
+#if TEST_LATENCY_PROBES
+    /* The delta covers formatting the message, so it is formatted first */
+    char text[256];
+    
+    log_message_format(text, sizeof(text), message);
+    if (cost == LOG_COST_MEASURE) {
+        cost = test_get_cycles() - timestamp;
+    }
+    
+#if TEST_LOG_REPEAT_SUPPRESS
+    if (log_repeat_check(level, text, strlen(text))) {
+        TRACE_END("test_log");
+        return;
+    }
+#endif
+    
+    char tag[64];
+    
+    log_sample_tag(tag, sizeof(tag), message->sampler);
+    used = (size_t)test_format(line, sizeof(line), "[%08" PRIu32 "+%" PRIu32 "] [%s] %s%s",
+                               timestamp,
+                               cost,
+                               log_level_strings[level],
+                               tag,
+                               text);
+#else
+    (void)cost;
+    
+    /* Prefix and message go straight into the line, with no intermediate buffer */
+    used = (size_t)test_format(line, sizeof(line), "[%08" PRIu32 "] [%s] ",
+                               timestamp,
+                               log_level_strings[level]);
+    used += (size_t)log_sample_tag(line + used, sizeof(line) - used, message->sampler);
+    
+#if TEST_LOG_REPEAT_SUPPRESS
+    const size_t prefix = used;
+#endif
+    used += (size_t)log_message_format(line + used, sizeof(line) - used, message);
+    
+#if TEST_LOG_REPEAT_SUPPRESS
+    if (log_repeat_check(level, line + prefix, (used < sizeof(line) ? used : sizeof(line) - 1u) - prefix)) {
+        TRACE_END("test_log");
+        return;
+    }
+#endif
+#endif
+    
+    if (used + 2u < sizeof(line)) {
+        line[used++] = '\r';
+        line[used++] = '\n';
+    } else {
+        used = sizeof(line);
+    }
+    test_rtt_write(level, line, line_length(line, sizeof(line), (int)used));
+    
+    TRACE_COUNTER("rtt_up_free", SEGGER_RTT_GetAvailWriteSpace(0));
+    TRACE_END("test_log");
+}
+
+#if TEST_LOG_DEFERRED
+#if (TEST_LOG_DEFER_DEPTH & (TEST_LOG_DEFER_DEPTH - 1u)) != 0
+#error "TEST_LOG_DEFER_DEPTH must be a power of two"
+#endif
+
+/* Everything log_emit() needs later; strings stay pointers */
+typedef struct {
+    uint32_t timestamp;
+    uint32_t cost;                      /* cycles the caller spent queuing it */
+    const char* format;
+    const test_log_sampler_t* sampler;
+    uint8_t level;
+    uint8_t count;
+    test_format_arg_t args[TEST_LOG_MAX_ARGS];
+} log_deferred_t;
+
+static log_deferred_t log_queue[TEST_LOG_DEFER_DEPTH];
+static volatile uint32_t log_queue_head = 0;    /* written by the logging code */
+static volatile uint32_t log_queue_tail = 0;    /* written by test_log_drain() */
+static bool log_queue_draining = false;
+static uint32_t log_queued = 0;
+static uint32_t log_queue_dropped = 0;
+static uint32_t log_queue_max_depth = 0;
+
+/* Producer side: no formatting, just the arguments; a full ring drops the line */
+static void log_defer(int level, uint32_t timestamp, const log_message_t* message) {
+    const uint32_t head = log_queue_head;
+    const uint32_t depth = head - log_queue_tail;
+    
+    if (depth >= TEST_LOG_DEFER_DEPTH) {
+        log_queue_dropped++;
+        return;
+    }
+    
+    log_deferred_t* record = &log_queue[head & (TEST_LOG_DEFER_DEPTH - 1u)];
+    record->timestamp = timestamp;
+    record->format = message->format;
+    record->sampler = message->sampler;
+    record->level = (uint8_t)level;
+    if (message->list != NULL) {
+        record->count = (uint8_t)test_format_capture(message->format, *message->list,
+                                                     record->args, TEST_LOG_MAX_ARGS);
+    } else {
+        record->count = (uint8_t)message->count;
+        memcpy(record->args, message->args, message->count * sizeof(record->args[0]));
+    }
+    record->cost = test_get_cycles() - timestamp;
+    
+    /* The record is complete before the drain can see it */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    log_queue_head = head + 1u;
+    
+    log_queued++;
+    if (depth + 1u > log_queue_max_depth) {
+        log_queue_max_depth = depth + 1u;
+    }
+}
+
+unsigned test_log_drain(void) {
+    unsigned drained = 0;
+    
+    /* An idle hook preempted mid-drain keeps the ring; the other caller skips */
+    if (__atomic_test_and_set(&log_queue_draining, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    
+    const uint32_t head = log_queue_head;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    
+    while (log_queue_tail != head) {
+        const log_deferred_t* record = &log_queue[log_queue_tail & (TEST_LOG_DEFER_DEPTH - 1u)];
+        const log_message_t message = { record->format, NULL, record->args, record->count, record->sampler };
+        
+        log_emit(record->level, record->timestamp, record->cost, &message);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        log_queue_tail++;
+        drained++;
+    }
+    
+    /* After the queued lines: they carry older timestamps than a SYNC written now */
+    clock_sync_if_due();
+    
+    __atomic_clear(&log_queue_draining, __ATOMIC_RELEASE);
+    return drained;
+}
+
+#if TEST_HOST_BUILD
+/* The host process has no idle loop after main() returns */
+static void log_drain_at_exit(void) {
+    test_log_drain();
+}
+#endif
+
+/* LOGDEFER:queued:dropped:max_depth:depth */
+static void log_defer_report(void) {
+    test_rtt_printf(TEST_RECORD_CONTROL, "LOGDEFER:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                    log_queued, log_queue_dropped, log_queue_max_depth, (uint32_t)TEST_LOG_DEFER_DEPTH);
+}
+#else
+unsigned test_log_drain(void) {
+    return 0;
+}
+#endif
+
+static void log_line(test_log_site_t* site, int level, const log_message_t* message) {
+#if !TEST_LOG_DEFERRED
+    /* A due SYNC goes out first, so no line follows one stamped later than itself */
+    clock_sync_if_due();
+#endif
+    uint32_t timestamp = test_get_cycles();
+    
+#if TEST_SOAK_MODE
+    /* Per-iteration log lines would flood the channel; only count them */
+    if (soak_iterations > 0) {
+        soak_log_counts[level & 3]++;
+        return;
+    }
+#endif
+    
+#if TEST_LOG_RATE_LIMIT > 0
+    /* Checked before formatting, so a flooding site costs little */
+    if (site != NULL && !log_site_allow(site)) {
+        return;
+    }
+#else
+    (void)site;
+#endif
+    
+#if TEST_LOG_DEFERRED
+    log_defer(level, timestamp, message);
+#else
+    log_emit(level, timestamp, LOG_COST_MEASURE, message);
+#endif
+}
+
+/* Queued and collapsed lines go out ahead of a record that must follow them,
+ * and ahead of a SYNC, which must not precede lines stamped before it */
+static void log_flush_pending(void) {
+#if TEST_LOG_DEFERRED
+    test_log_drain();
+#endif
+#if TEST_LOG_REPEAT_SUPPRESS
+    log_repeat_flush();
+#endif
 }
 
 void test_log(int level, const char* format, ...) {
-    char buffer[256];
     va_list args;
     
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    const log_message_t message = { format, &args, NULL, 0, NULL };
+    log_line(NULL, level, &message);
+    va_end(args);
+}
+
+void test_log_at(test_log_site_t* site, int level, const char* format, ...) {
+    va_list args;
+    
+    va_start(args, format);
+    const log_message_t message = { format, &args, NULL, 0, NULL };
+    log_line(site, level, &message);
     va_end(args);
+}
+
+void test_log_sampled(test_log_sampler_t* sampler, int level, const char* format, ...) {
+    va_list args;
     
-    uint32_t timestamp = SEGGER_RTT_GetUpBufferReadPos(0);
+    sampler->emitted++;
+    va_start(args, format);
+    const log_message_t message = { format, &args, NULL, 0, sampler };
+    log_line(&sampler->site, level, &message);
+    va_end(args);
+}
+
+void test_log_record(const test_log_record_t* record) {
+    const log_message_t message = { record->format, NULL, record->args, record->count, record->sampler };
     
-    SEGGER_RTT_printf(0, "[%08lu] [%s] %s\r\n", 
-                     timestamp, 
-                     log_level_strings[level], 
-                     buffer);
+    if (record->sampler != NULL) {
+        record->sampler->emitted++;
+    }
+    log_line(record->site, record->level, &message);
+}
+
+/* KV line under construction; used keeps counting past size so overflow can be undone */
+typedef struct {
+    char* line;
+    size_t size;
+    size_t used;
+} kv_line_t;
+
+static void kv_put(kv_line_t* kv, char c) {
+    if (kv->used < kv->size) {
+        kv->line[kv->used] = c;
+    }
+    kv->used++;
+}
+
+static void kv_append(kv_line_t* kv, const char* format, ...) {
+    const size_t offset = kv->used < kv->size ? kv->used : kv->size;
+    va_list args;
+    
+    va_start(args, format);
+    kv->used += (size_t)test_vformat(kv->line + offset, kv->size - offset, format, args);
+    va_end(args);
+}
+
+/* %XX for the separators and control characters, so names and strings stay one token */
+static void kv_put_escaped(kv_line_t* kv, const char* s) {
+    static const char hex[] = "0123456789ABCDEF";
+    
+    if (s == NULL) {
+        s = "(null)";
+    }
+    for (; *s != '\0'; s++) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '%' || c == ' ' || c == '=' || c < 0x20u || c == 0x7Fu) {
+            kv_put(kv, '%');
+            kv_put(kv, hex[c >> 4]);
+            kv_put(kv, hex[c & 0x0Fu]);
+        } else {
+            kv_put(kv, (char)c);
+        }
+    }
+}
+
+void test_log_kv(int level, const char* event, const test_kv_t* fields, size_t count) {
+    char line[TEST_WRITE_LINE_MAX];
+    /* " ...\r\n" always fits after the fields */
+    kv_line_t kv = { line, sizeof(line) - 6u, 0 };
+    bool cut = false;
+    
+#if TEST_SOAK_MODE
+    if (soak_iterations > 0) {
+        soak_log_counts[level & 3]++;
+        return;
+    }
+#endif
+    
+    log_flush_pending();
+    clock_sync_if_due();
+    
+    kv_append(&kv, "KV:%" PRIu32 ":%d:", test_get_cycles(), level);
+    kv_put_escaped(&kv, event);
+    
+    for (size_t i = 0; i < count && !cut; i++) {
+        const test_kv_t* field = &fields[i];
+        const size_t mark = kv.used;
+        
+        kv_put(&kv, ' ');
+        kv_put_escaped(&kv, field->key);
+        kv_append(&kv, "=%c:", field->type);
+        switch (field->type) {
+            case TEST_KV_INT:
+                kv_append(&kv, "%lld", (long long)field->value.i);
+                break;
+            case TEST_KV_UINT:
+            case TEST_KV_BOOL:
+                kv_append(&kv, "%llu", (unsigned long long)field->value.u);
+                break;
+            case TEST_KV_FLOAT: {
+                /* Bit-exact and needs no float formatting on target */
+                uint64_t bits;
+                memcpy(&bits, &field->value.f, sizeof(bits));
+                kv_append(&kv, "%016llx", (unsigned long long)bits);
+                break;
+            }
+            default:
+                kv_put_escaped(&kv, field->value.s);
+                break;
+        }
+        
+        /* Fields are sent whole or not at all */
+        if (kv.used > kv.size) {
+            kv.used = mark;
+            cut = true;
+        }
+    }
+    
+    /* Only an over-long event name is still past the end here */
+    if (kv.used > kv.size) {
+        kv.used = kv.size;
+        cut = true;
+    }
+    
+    size_t used = kv.used;
+    if (cut) {
+        memcpy(line + used, " ...", 4);
+        used += 4;
+    }
+    line[used++] = '\r';
+    line[used++] = '\n';
+    test_rtt_write(level, line, (unsigned)used);
 }
 
 void test_status(const char* status, const char* test_name) {
-    SEGGER_RTT_printf(0, "STATUS:%s:%s\r\n", status, test_name);
+#if TEST_FLOW_ENABLED
+    /* Picks up the host's first grants; after that producers poll on demand */
+    test_flow_poll();
+#endif
+    
+    if (strcmp(status, TEST_STATUS_RUNNING) == 0) {
+        test_start_cycles = test_get_cycles();
+        test_start_blocked = write_blocked_cycles;
+        running_test = test_name;
+        TRACE_BEGIN(test_name);
+#if TEST_OCCUPANCY_ENABLED
+        memset(&occupancy, 0, sizeof(occupancy));
+#endif
+    }
+    
+#if TEST_SOAK_MODE
+    if (soak_iterations > 0) {
+        return;
+    }
+#endif
+    
+    log_flush_pending();
+    clock_sync_if_due();
+    test_rtt_printf(TEST_RECORD_CONTROL, "STATUS:%s:%s\r\n", status, test_name);
 }
 
 void test_result(const char* test_name, bool passed, uint32_t duration_ms) {
+    /* Time spent waiting for the host in blocking writes is the logger's, not the test's */
+    const uint32_t blocked_cycles = write_blocked_cycles - test_start_blocked;
+    uint32_t duration_cycles = test_get_cycles() - test_start_cycles;
+    duration_cycles = duration_cycles > blocked_cycles ? duration_cycles - blocked_cycles : 0u;
+    
+    TRACE_END(test_name);
     test_counter++;
+    running_test = NULL;
+    
+#if TEST_SOAK_MODE
+    if (soak_iterations > 0) {
+        if (passed) {
+            passed_tests++;
+        } else {
+            failed_tests++;
+        }
+        soak_record_result(test_name, passed, duration_cycles);
+        return;
+    }
+#endif
     
+    /* One call site for every test: not rate limited */
     if (passed) {
         passed_tests++;
-        TEST_LOG_INFO("✓ PASS: %s (%lu ms)", test_name, duration_ms);
+        test_log(TEST_LOG_LEVEL_INFO, "✓ PASS: %s (%" PRIu32 " ms)", test_name, duration_ms);
         test_status(TEST_STATUS_PASS, test_name);
     } else {
         failed_tests++;
-        TEST_LOG_ERROR("✗ FAIL: %s (%lu ms)", test_name, duration_ms);
+        test_log(TEST_LOG_LEVEL_ERROR, "✗ FAIL: %s (%" PRIu32 " ms)", test_name, duration_ms);
         test_status(TEST_STATUS_FAIL, test_name);
     }
     
-    SEGGER_RTT_printf(0, "RESULT:%s:%s:%lu\r\n", 
-                     test_name, 
-                     passed ? "PASS" : "FAIL", 
-                     duration_ms);
+    test_rtt_printf(TEST_RECORD_CONTROL, "RESULT:%s:%s:%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n", 
+                    test_name, 
+                    passed ? "PASS" : "FAIL", 
+                    duration_ms,
+                    duration_cycles,
+                    blocked_cycles);
+    
+#if TEST_METRICS_SNAPSHOT_ON_RESULT
+    test_metrics_snapshot(test_name);
+#if !TEST_SOAK_MODE
+    /* The next test's scope starts empty; soak snapshots stay cumulative */
+    test_metrics_reset();
+#endif
+#endif
+#if TEST_OCCUPANCY_ENABLED
+    occupancy_report(test_name);
+#endif
+#if TEST_LOG_RATE_LIMIT > 0
+    log_limit_report();
+#endif
+}
+
+const char* test_running(uint32_t* index) {
+    if (index != NULL) {
+        *index = running_test != NULL ? test_counter + 1u : 0u;
+    }
+    return running_test;
 }
 
 void test_assert(bool condition, const char* message) {
     if (!condition) {
-        TEST_LOG_ERROR("ASSERTION FAILED: %s", message);
+        test_log(TEST_LOG_LEVEL_ERROR, "ASSERTION FAILED: %s", message);
         test_status(TEST_STATUS_FAIL, "Assertion");
     }
 }
 
+void test_run(void (*test_fn)(void)) {
+    for (uint32_t i = 0; i < TEST_REPEAT_COUNT; i++) {
+        test_fn();
+    }
+}
+
+#if TEST_SOAK_MODE
+void test_soak_snapshot(void) {
+    test_clock_sync();
+    test_rtt_printf(TEST_RECORD_CONTROL, "SOAK:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n",
+                    soak_iterations,
+                    (uint32_t)(soak_elapsed_cycles / (TEST_CPU_HZ / 1000u)),
+                    test_counter, passed_tests, failed_tests,
+                    soak_log_counts[TEST_LOG_LEVEL_ERROR],
+                    soak_log_counts[TEST_LOG_LEVEL_WARN],
+                    soak_overflow_tests);
+    
+    for (uint32_t i = 0; i < soak_entry_count; i++) {
+        const soak_entry_t* entry = &soak_entries[i];
+        char hist[TEST_SOAK_HIST_BUCKETS * 14];
+        int len = 0;
+        
+        /* Sparse histogram: bucket=count pairs for non-empty buckets only */
+        for (uint32_t b = 0; b < TEST_SOAK_HIST_BUCKETS; b++) {
+            if (entry->hist[b] != 0) {
+                len += test_format(hist + len, sizeof(hist) - len, "%s%" PRIu32 "=%" PRIu32,
+                                len > 0 ? "," : "", b, entry->hist[b]);
+            }
+        }
+        hist[len] = '\0';
+        
+        test_rtt_printf(TEST_RECORD_CONTROL, "SOAKTEST:%s:%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%" PRIu32 ":%s\r\n",
+                        entry->name, entry->runs, entry->passed, entry->failed,
+                        entry->runs > 0 ? entry->min_cycles : 0u,
+                        entry->max_cycles, hist);
+    }
+    
+    test_metrics_snapshot("soak");
+#if TEST_PROFILER_ENABLED
+    test_profiler_drain();
+#endif
+}
+
+void test_soak_loop(void (*suite_fn)(void)) {
+    const uint64_t snapshot_cycles = (uint64_t)TEST_SOAK_SNAPSHOT_MS * (TEST_CPU_HZ / 1000u);
+    uint64_t next_snapshot = snapshot_cycles;
+    uint32_t last_cycles = test_get_cycles();
+    
+    TEST_LOG_INFO("=== Soak mode: snapshots every %" PRIu32 " ms ===", (uint32_t)TEST_SOAK_SNAPSHOT_MS);
+    
+    for (;;) {
+        soak_iterations++;
+        suite_fn();
+        
+        /* Accumulate deltas so the 32-bit cycle counter may wrap between iterations */
+        uint32_t now = test_get_cycles();
+        soak_elapsed_cycles += (uint32_t)(now - last_cycles);
+        last_cycles = now;
+        
+        if (soak_elapsed_cycles >= next_snapshot) {
+            test_soak_snapshot();
+            next_snapshot = soak_elapsed_cycles + snapshot_cycles;
+        }
+    }
+}
+#endif
+
 void test_summary(void) {
     TEST_LOG_INFO("=== Test Summary ===");
-    TEST_LOG_INFO("Total Tests: %lu", test_counter);
-    TEST_LOG_INFO("Passed: %lu", passed_tests);
-    TEST_LOG_INFO("Failed: %lu", failed_tests);
-    TEST_LOG_INFO("Success Rate: %lu%%", 
+    TEST_LOG_INFO("Total Tests: %" PRIu32, test_counter);
+    TEST_LOG_INFO("Passed: %" PRIu32, passed_tests);
+    TEST_LOG_INFO("Failed: %" PRIu32, failed_tests);
+    TEST_LOG_INFO("Success Rate: %" PRIu32 "%%", 
                  test_counter > 0 ? (passed_tests * 100) / test_counter : 0);
     
-    test_status(TEST_STATUS_COMPLETE, "All Tests");
+#if TEST_TRACE_ENABLED
+    test_trace_report();
+#endif
+#if TEST_FUNC_TRACE_ENABLED
+    test_func_trace_report();
+#endif
+#if TEST_PROFILER_ENABLED
+    test_profiler_stop();
+    test_profiler_drain();
+#endif
+#if TEST_COVERAGE_ENABLED
+    test_coverage_dump();
+#endif
+#if TEST_BULK_ENABLED
+    test_bulk_report();
+#endif
+#if TEST_FLOW_ENABLED
+    test_flow_report();
+#endif
+    
+    write_stats_report();
+    log_sample_report();
+#if TEST_LOG_DEFERRED
+    log_defer_report();
+#endif
+#if TEST_LOG_RATE_LIMIT > 0 || TEST_LOG_REPEAT_SUPPRESS
+    uint32_t rate_limited = 0;
+    uint32_t repeats = 0;
+#if TEST_LOG_RATE_LIMIT > 0
+    log_limit_report();
+    rate_limited = log_rate_limited;
+#endif
+#if TEST_LOG_REPEAT_SUPPRESS
+    log_repeat_flush();
+    repeats = log_repeats;
+#endif
+    if (rate_limited > 0 || repeats > 0) {
+        test_rtt_printf(TEST_RECORD_CONTROL, "LOGSUPPRESS:%" PRIu32 ":%" PRIu32 "\r\n", rate_limited, repeats);
+    }
+#endif
+#if TEST_LOG_COMPRESS
+    /* After the repeat flush, which may still send a line */
+    test_logz_report();
+#endif
     
-    SEGGER_RTT_printf(0, "SUMMARY:%lu:%lu:%lu\r\n", 
-                     test_counter, passed_tests, failed_tests);
+    test_rtt_printf(TEST_RECORD_CONTROL, "SUMMARY:%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n", 
+                    test_counter, passed_tests, failed_tests);
+    /* Last: a monitor may stop reading as soon as it sees this */
+    test_status(TEST_STATUS_COMPLETE, "All Tests");
+#if TEST_POSTMORTEM_ENABLED
+    test_postmortem_complete();
+#endif
 }
\ No newline at end of file
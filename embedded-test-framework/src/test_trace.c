@@ -0,0 +1,114 @@
+#include "test_trace.h"
+#include "test_rtt_logger.h"
+#include "test_flow.h"
+#include <string.h>
+
+#if TEST_TRACE_ENABLED
+
+typedef struct {
+    const char* name;
+    uint8_t id;
+    bool defined;
+} trace_name_t;
+
+static char trace_buffer[RTT_BUFFER_TRACE_SIZE];
+static trace_name_t trace_names[TEST_TRACE_MAX_NAMES];
+static uint32_t trace_name_count = 0;
+static uint32_t trace_events = 0;
+static uint32_t trace_dropped = 0;
+static uint32_t trace_lost_pending = 0;
+/* One object, so the name interns (by address) to the same slot at every use */
+static const char trace_lost_name[] = TEST_TRACE_LOST_NAME;
+
+static trace_name_t* trace_intern(const char* name);
+
+void test_trace_init(void) {
+    /* SKIP mode keeps records whole: a record is written completely or not at all */
+    SEGGER_RTT_ConfigUpBuffer(RTT_CHANNEL_TRACE, "Trace", trace_buffer, sizeof(trace_buffer),
+                              SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    test_flow_register(RTT_CHANNEL_TRACE, sizeof(trace_buffer));
+
+    /* Takes its slot before the table can fill: a gap must always be reportable */
+    trace_intern(trace_lost_name);
+}
+
+static trace_name_t* trace_intern(const char* name) {
+    uint32_t slot = ((uint32_t)(uintptr_t)name * 2654435761u) & (TEST_TRACE_MAX_NAMES - 1);
+
+    for (uint32_t probe = 0; probe < TEST_TRACE_MAX_NAMES; probe++) {
+        trace_name_t* entry = &trace_names[slot];
+
+        if (entry->name == name) {
+            return entry;
+        }
+        if (entry->name == NULL) {
+            entry->name = name;
+            entry->id = (uint8_t)trace_name_count++;
+            return entry;
+        }
+        slot = (slot + 1) & (TEST_TRACE_MAX_NAMES - 1);
+    }
+
+    return NULL;
+}
+
+static bool trace_define(trace_name_t* entry) {
+    uint8_t record[3 + 255];
+    size_t len = strlen(entry->name);
+
+    if (len > 255) {
+        len = 255;
+    }
+
+    record[0] = TEST_TRACE_DEFINE;
+    record[1] = entry->id;
+    record[2] = (uint8_t)len;
+    memcpy(&record[3], entry->name, len);
+
+    entry->defined = test_flow_write(RTT_CHANNEL_TRACE, record, (unsigned)(3 + len)) == 3 + len;
+    return entry->defined;
+}
+
+static bool trace_write(uint8_t type, const char* name, int32_t value, uint32_t cycles) {
+    uint8_t record[10];
+    unsigned len = (type == TEST_TRACE_COUNTER) ? 10u : 6u;
+
+    trace_name_t* entry = trace_intern(name);
+    if (entry == NULL || (!entry->defined && !trace_define(entry))) {
+        return false;
+    }
+
+    record[0] = type;
+    record[1] = entry->id;
+    memcpy(&record[2], &cycles, sizeof(cycles));
+    memcpy(&record[6], &value, sizeof(value));
+
+    return test_flow_write(RTT_CHANNEL_TRACE, record, len) == len;
+}
+
+void test_trace_event(uint8_t type, const char* name, int32_t value) {
+    uint32_t cycles = test_get_cycles();
+
+    /* Nothing follows a gap until the gap itself has been reported */
+    if (trace_lost_pending != 0) {
+        if (!trace_write(TEST_TRACE_COUNTER, trace_lost_name, (int32_t)trace_lost_pending, cycles)) {
+            trace_lost_pending++;
+            trace_dropped++;
+            return;
+        }
+        trace_lost_pending = 0;
+    }
+
+    if (trace_write(type, name, value, cycles)) {
+        trace_events++;
+    } else {
+        trace_lost_pending++;
+        trace_dropped++;
+    }
+}
+
+void test_trace_report(void) {
+    test_rtt_printf(TEST_RECORD_CONTROL, "TRACESTAT:%" PRIu32 ":%" PRIu32 ":%" PRIu32 "\r\n", trace_events, trace_dropped, trace_name_count);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "test_rtt_logger.h"
+#include "test_bulk.h"
+
+#if TEST_BULK_ENABLED
+
+#define BULK_CHECK_COUNT 300u
+
+/* Flat, ramping and wrapping stretches: zero, small and negative deltas, and runs for RLE */
+static uint16_t bulk_check_samples[BULK_CHECK_COUNT];
+
+static void fill_bulk_check_samples(void) {
+    for (uint32_t i = 0; i < BULK_CHECK_COUNT; i++) {
+        if (i < 100u) {
+            bulk_check_samples[i] = 500u;
+        } else if (i < 200u) {
+            bulk_check_samples[i] = (uint16_t)(500u + (i - 100u) * 3u);
+        } else {
+            bulk_check_samples[i] = (uint16_t)(65430u + i);
+        }
+    }
+}
+
+/* The host (bulk_dump.py --match bulk_check_raw=bulk_check_encoded) compares the two */
+void test_bulk_dump_round_trip(void) {
+    const char* test_name = "Bulk Dump Round Trip";
+    
+    test_status(TEST_STATUS_RUNNING, test_name);
+    TEST_LOG_INFO("Starting test: %s", test_name);
+    
+    bool all_passed = true;
+    
+    fill_bulk_check_samples();
+    
+    if (!test_dump_array("bulk_check_raw", bulk_check_samples, BULK_CHECK_COUNT, TEST_BULK_U16, 0)) {
+        TEST_LOG_ERROR("Raw dump did not fit on the bulk channel");
+        all_passed = false;
+    }
+    
+    if (!test_dump_array("bulk_check_encoded", bulk_check_samples, BULK_CHECK_COUNT, TEST_BULK_U16,
+                         TEST_BULK_DELTA | TEST_BULK_RLE)) {
+        TEST_LOG_ERROR("Encoded dump did not fit on the bulk channel");
+        all_passed = false;
+    }
+    
+    test_result(test_name, all_passed, 0);
+}
+
+#endif
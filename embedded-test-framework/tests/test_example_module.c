@@ -3,6 +3,13 @@
 #include <string.h>
 
 extern void test_summary(void);
+extern void test_format_round_trip(void);
+extern void test_format_truncation(void);
+extern void test_bulk_dump_round_trip(void);
+extern void test_profile_workload(void);
+#if TEST_HOST_BUILD
+extern void test_log_cpp_front_end(void);
+#endif
 
 static uint32_t get_timestamp_ms(void) {
     return get_system_tick() * 10;
@@ -40,19 +47,19 @@ void test_calculate_sum_normal_cases(void) {
     
     int32_t result1 = calculate_sum(10, 20);
     if (result1 != 30) {
-        TEST_LOG_ERROR("Expected 30, got %ld", result1);
+        TEST_LOG_ERROR("Expected 30, got %" PRId32, result1);
         all_passed = false;
     }
     
     int32_t result2 = calculate_sum(-5, 15);
     if (result2 != 10) {
-        TEST_LOG_ERROR("Expected 10, got %ld", result2);
+        TEST_LOG_ERROR("Expected 10, got %" PRId32, result2);
         all_passed = false;
     }
     
     int32_t result3 = calculate_sum(0, 0);
     if (result3 != 0) {
-        TEST_LOG_ERROR("Expected 0, got %ld", result3);
+        TEST_LOG_ERROR("Expected 0, got %" PRId32, result3);
         all_passed = false;
     }
     
@@ -71,19 +78,19 @@ void test_calculate_sum_edge_cases(void) {
     
     int32_t result1 = calculate_sum(INT32_MAX, 0);
     if (result1 != INT32_MAX) {
-        TEST_LOG_ERROR("Max value test failed: expected %ld, got %ld", INT32_MAX, result1);
+        TEST_LOG_ERROR("Max value test failed: expected %" PRId32 ", got %" PRId32, INT32_MAX, result1);
         all_passed = false;
     }
     
     int32_t result2 = calculate_sum(INT32_MIN, 0);
     if (result2 != INT32_MIN) {
-        TEST_LOG_ERROR("Min value test failed: expected %ld, got %ld", INT32_MIN, result2);
+        TEST_LOG_ERROR("Min value test failed: expected %" PRId32 ", got %" PRId32, INT32_MIN, result2);
         all_passed = false;
     }
     
     int32_t result3 = calculate_sum(INT32_MAX, 1);
     if (result3 != 0) {
-        TEST_LOG_WARN("Overflow test: expected 0 (overflow protection), got %ld", result3);
+        TEST_LOG_WARN("Overflow test: expected 0 (overflow protection), got %" PRId32, result3);
     }
     
     uint32_t duration = get_timestamp_ms() - start_time;
@@ -154,6 +161,25 @@ void test_system_reset_functionality(void) {
     test_result(test_name, reset_successful, duration);
 }
 
+static void run_test_suite(void) {
+    TEST_RUN(test_system_initialization);
+    TEST_RUN(test_calculate_sum_normal_cases);
+    TEST_RUN(test_calculate_sum_edge_cases);
+    TEST_RUN(test_validate_range_function);
+    TEST_RUN(test_system_reset_functionality);
+    TEST_RUN(test_format_round_trip);
+    TEST_RUN(test_format_truncation);
+#if TEST_BULK_ENABLED
+    TEST_RUN(test_bulk_dump_round_trip);
+#endif
+#if TEST_PROFILER_ENABLED
+    TEST_RUN(test_profile_workload);
+#endif
+#if TEST_HOST_BUILD
+    TEST_RUN(test_log_cpp_front_end);
+#endif
+}
+
 int main(void) {
     test_rtt_init();
     
@@ -161,11 +187,11 @@ int main(void) {
     
     system_init();
     
-    test_system_initialization();
-    test_calculate_sum_normal_cases();
-    test_calculate_sum_edge_cases();
-    test_validate_range_function();
-    test_system_reset_functionality();
+#if TEST_SOAK_MODE
+    test_soak_loop(run_test_suite);
+#endif
+    
+    run_test_suite();
     
     test_summary();
     
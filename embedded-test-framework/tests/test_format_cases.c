@@ -0,0 +1,104 @@
+#include "test_rtt_logger.h"
+#include "test_format.h"
+#include <string.h>
+
+/* Formats into a buffer larger than any case and checks the text and return value */
+static bool format_case(const char* expected, const char* format, ...) TEST_FORMAT_PRINTF(2, 3);
+
+static bool format_case(const char* expected, const char* format, ...) {
+    char out[64];
+    va_list args;
+    int length;
+    
+    va_start(args, format);
+    length = test_vformat(out, sizeof(out), format, args);
+    va_end(args);
+    
+    if (strcmp(out, expected) != 0 || length != (int)strlen(expected)) {
+        TEST_LOG_ERROR("\"%s\": expected \"%s\", got \"%s\" (length %d)", format, expected, out, length);
+        return false;
+    }
+    return true;
+}
+
+/* Also logs the case as "FMTCHECK:<n>:<expected><output>|", so the monitor checks it
+ * again as received: through the compressor and decoder when COMPRESS=1 */
+#define FORMAT_CASE(expected, format, ...) \
+    do { \
+        if (!format_case(expected, format, __VA_ARGS__)) { \
+            all_passed = false; \
+        } \
+        TEST_LOG_INFO("FMTCHECK:%u:%s" format "|", (unsigned)strlen(expected), expected, __VA_ARGS__); \
+    } while (0)
+
+void test_format_round_trip(void) {
+    const char* test_name = "Format Round Trip";
+    
+    test_status(TEST_STATUS_RUNNING, test_name);
+    TEST_LOG_INFO("Starting test: %s", test_name);
+    
+    bool all_passed = true;
+    
+    /* Width, flags and precision */
+    FORMAT_CASE("   42", "%5d", 42);
+    FORMAT_CASE("42   |", "%-5d|", 42);
+    FORMAT_CASE("-0042", "%05d", -42);
+    FORMAT_CASE("+7 7", "%+d% d", 7, 7);
+    FORMAT_CASE("005", "%.3d", 5);
+    FORMAT_CASE("    -005", "%8.3d", -5);
+    FORMAT_CASE("[]", "[%.0d]", 0);
+    FORMAT_CASE("ff FF 10", "%x %X %o", 255u, 255u, 8u);
+    FORMAT_CASE("    ab|ab    |", "%6s|%-6s|", "ab", "ab");
+    FORMAT_CASE("ok", "%c%c", 'o', 'k');
+    
+    /* Width and precision from the arguments */
+    FORMAT_CASE("   123|123   |", "%*d|%-*d|", 6, 123, 6, 123);
+    FORMAT_CASE(" -0012", "%*.*d", 6, 4, -12);
+    FORMAT_CASE("abc", "%.*s", 3, "abcdef");
+    
+    /* Literal percent signs */
+    FORMAT_CASE("50% of 100%", "%d%% of %d%%", 50, 100);
+    
+    /* Negative and full-range values in every length */
+    FORMAT_CASE("-2147483648", "%" PRId32, INT32_MIN);
+    FORMAT_CASE("4294967295", "%" PRIu32, UINT32_MAX);
+    FORMAT_CASE("-9000000000", "%lld", -9000000000LL);
+    FORMAT_CASE("18446744073709551615", "%llu", 18446744073709551615ULL);
+    FORMAT_CASE("-56 44", "%hhd %hhu", 200, 300);
+    FORMAT_CASE("-1", "%hd", 65535);
+    
+    test_result(test_name, all_passed, 0);
+}
+
+/* Output cut at the buffer end: always terminated, return value is the full length */
+static bool truncation_case(size_t size, const char* expected, int full_length, const char* format, int value) {
+    char out[16];
+    int length;
+    
+    memset(out, 'x', sizeof(out));
+    length = test_format(out, size, format, value);
+    
+    if (strcmp(out, expected) != 0 || length != full_length || out[size] != 'x') {
+        TEST_LOG_ERROR("\"%s\" into %d bytes: expected \"%s\" (%d), got \"%s\" (%d)",
+                       format, (int)size, expected, full_length, out, length);
+        return false;
+    }
+    return true;
+}
+
+void test_format_truncation(void) {
+    const char* test_name = "Format Truncation";
+    
+    test_status(TEST_STATUS_RUNNING, test_name);
+    TEST_LOG_INFO("Starting test: %s", test_name);
+    
+    bool all_passed = true;
+    
+    all_passed &= truncation_case(4, "123", 6, "%d", 123456);
+    all_passed &= truncation_case(6, "     ", 10, "%10d", 7);
+    all_passed &= truncation_case(5, "-000", 6, "%06d", -42);
+    all_passed &= truncation_case(8, "value: ", 9, "value: %d", 42);
+    all_passed &= truncation_case(1, "", 3, "%d", 100);
+    
+    test_result(test_name, all_passed, 0);
+}
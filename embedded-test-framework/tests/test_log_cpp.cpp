@@ -0,0 +1,73 @@
+#include "test_log.hpp"
+#include <cstring>
+
+/* Host-only: compiling this file keeps test_log.hpp and its format checks building */
+
+namespace {
+
+using test_rtt::detail::format_error;
+
+/* Formats the macros must reject; checked here without tripping their static_asserts */
+struct float_format {
+    static constexpr const char* value() { return "ratio=%f"; }
+};
+struct unknown_format {
+    static constexpr const char* value() { return "value=%q"; }
+};
+struct int_format {
+    static constexpr const char* value() { return "count=%d"; }
+};
+struct unsigned_format {
+    static constexpr const char* value() { return "mask=%x"; }
+};
+struct string_format {
+    static constexpr const char* value() { return "name=%s"; }
+};
+
+template <typename Format, typename... Args>
+constexpr format_error arg_error() {
+    return test_rtt::detail::check_args<Format, Args...>(std::index_sequence_for<Args...>{});
+}
+
+static_assert(test_rtt::detail::parse_format<float_format>().error == format_error::floating_point, "%f accepted");
+static_assert(test_rtt::detail::parse_format<unknown_format>().error == format_error::unknown_conversion,
+              "%q accepted");
+static_assert(arg_error<int_format, std::int64_t>() == format_error::too_wide, "int64_t accepted for %d");
+static_assert(arg_error<int_format, double>() == format_error::floating_point, "double accepted for %d");
+static_assert(arg_error<unsigned_format, std::int32_t>() == format_error::type_mismatch, "int32_t accepted for %x");
+static_assert(arg_error<string_format, int>() == format_error::type_mismatch, "int accepted for %s");
+static_assert(arg_error<int_format, std::uint8_t>() == format_error::none, "uint8_t rejected for %d");
+
+} // namespace
+
+/* Same FMTCHECK line as tests/test_format_cases.c, through the C++ front end */
+#define CPP_FORMAT_CASE(expected, format, ...) \
+    TEST_LOG_INFO("FMTCHECK:%u:%s" format "|", (unsigned)std::strlen(expected), expected, __VA_ARGS__)
+
+extern "C" void test_log_cpp_front_end(void) {
+    const char* test_name = "C++ Log Front End";
+    
+    test_status(TEST_STATUS_RUNNING, test_name);
+    TEST_LOG_INFO("Starting test: %s", test_name);
+    
+    const std::int32_t sum = -5;
+    const std::uint32_t tries = 7u;
+    const std::uint8_t small = 200u;
+    const std::int64_t big = -1234567890123LL;
+    const char* name = "adc";
+    char label[] = "arr";
+    
+    /* Every accepted form, including integers narrower than their conversion */
+    TEST_LOG_INFO("C++ front end without arguments");
+    CPP_FORMAT_CASE("sum=-5 after 7 tries", "sum=%ld after %lu tries", sum, tries);
+    CPP_FORMAT_CASE("200 200 -1234567890123", "%d %u %lld", small, small, big);
+    CPP_FORMAT_CASE("adc|arr   |xy|    5|q", "%s|%-6s|%.2s|%*d|%c", name, label, "xyz", 5, 5, 'q');
+    CPP_FORMAT_CASE("0000BEEF 4 %", "%08lX %zu %%", 0xBEEFul, sizeof(sum));
+    TEST_LOG_DEBUG("label at %p", (const void*)label);
+    TEST_LOG_WARN("%s", "C++ warning");
+    TEST_LOG_SAMPLED(TEST_LOG_LEVEL_DEBUG, 8, "sampled sum=%ld", sum);
+    TEST_LOG_KV(TEST_LOG_LEVEL_INFO, "cpp_front_end", "sum", sum, "big", big, "name", name, "ratio", 2.5,
+                "ok", true);
+    
+    test_result(test_name, true, 0);
+}
@@ -0,0 +1,54 @@
+#include "test_rtt_logger.h"
+#include "test_profiler.h"
+
+#if TEST_PROFILER_ENABLED
+
+/* CPU time the workload burns; at TEST_PROFILER_RATE_HZ this is ~100 samples */
+#ifndef TEST_PROFILE_WORKLOAD_MS
+#define TEST_PROFILE_WORKLOAD_MS 100u
+#endif
+
+#define WORKLOAD_BUFFER_SIZE 256u
+
+static uint8_t workload_buffer[WORKLOAD_BUFFER_SIZE];
+
+/* Bitwise CRC-32: slow on purpose, so the samples land in one recognisable function */
+static uint32_t __attribute__((noinline)) workload_crc32(const uint8_t* data, uint32_t length) {
+    uint32_t crc = 0xFFFFFFFFu;
+    
+    for (uint32_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/* The rest of the suite finishes between two profiler ticks; this gives it something to sample */
+void test_profile_workload(void) {
+    const char* test_name = "Profiler Workload";
+    const uint32_t budget = TEST_PROFILE_WORKLOAD_MS * (TEST_CPU_HZ / 1000u);
+    
+    test_status(TEST_STATUS_RUNNING, test_name);
+    TEST_LOG_INFO("Starting test: %s", test_name);
+    
+    for (uint32_t i = 0; i < WORKLOAD_BUFFER_SIZE; i++) {
+        workload_buffer[i] = (uint8_t)(i * 7u);
+    }
+    
+    const uint32_t start = test_get_cycles();
+    uint32_t crc = 0;
+    uint32_t rounds = 0;
+    
+    while (test_get_cycles() - start < budget) {
+        workload_buffer[0] = (uint8_t)crc;
+        crc = workload_crc32(workload_buffer, WORKLOAD_BUFFER_SIZE);
+        rounds++;
+    }
+    
+    TEST_LOG_INFO("%" PRIu32 " CRC rounds, result 0x%08" PRIx32, rounds, crc);
+    test_result(test_name, rounds > 0, TEST_PROFILE_WORKLOAD_MS);
+}
+
+#endif